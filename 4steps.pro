@@ -18,7 +18,10 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 
 SOURCES += \
+    alphabeta.cpp \
     analysis.cpp \
+    analysiscache.cpp \
+    analysismodel.cpp \
     arimaa_com.cpp \
     asip.cpp \
     asip1.cpp \
@@ -27,29 +30,45 @@ SOURCES += \
     bots.cpp \
     creategame.cpp \
     duration.cpp \
+    engine.cpp \
+    enginepool.cpp \
     game.cpp \
     gamelist.cpp \
     gamestate.cpp \
+    generator.cpp \
     iconengine.cpp \
+    loadtest.cpp \
+    localgame.cpp \
     login.cpp \
     main.cpp \
     mainwindow.cpp \
+    montecarlo.cpp \
     node.cpp \
     offboard.cpp \
     opengame.cpp \
     palette.cpp \
     pieceicons.cpp \
     playerbar.cpp \
+    pollscheduler.cpp \
+    prefetcher.cpp \
     puzzles.cpp \
     server.cpp \
+    sessionlog.cpp \
+    solver.cpp \
+    standinserver.cpp \
     startanalysis.cpp \
+    threatannotator.cpp \
     timecontrol.cpp \
     timeestimator.cpp \
+    tournament.cpp \
     treemodel.cpp \
     turnstate.cpp
 
 HEADERS += \
+    alphabeta.hpp \
     analysis.hpp \
+    analysiscache.hpp \
+    analysismodel.hpp \
     arimaa_com.hpp \
     asip.hpp \
     asip1.hpp \
@@ -59,30 +78,44 @@ HEADERS += \
     creategame.hpp \
     def.hpp \
     duration.hpp \
+    engine.hpp \
+    enginepool.hpp \
     game.hpp \
     gamelist.hpp \
     gamestate.hpp \
+    generator.hpp \
     globals.hpp \
     iconengine.hpp \
     io.hpp \
+    loadtest.hpp \
+    localgame.hpp \
     login.hpp \
     mainwindow.hpp \
     messagebox.hpp \
+    montecarlo.hpp \
     node.hpp \
     offboard.hpp \
     opengame.hpp \
     palette.hpp \
     pieceicons.hpp \
     playerbar.hpp \
+    pollscheduler.hpp \
     potentialmove.hpp \
+    prefetcher.hpp \
     puzzles.hpp \
     readonly.hpp \
     server.hpp \
+    sessionlog.hpp \
+    solver.hpp \
+    standinserver.hpp \
     startanalysis.hpp \
+    threatannotator.hpp \
     timecontrol.hpp \
     timeestimator.hpp \
+    tournament.hpp \
     treemodel.hpp \
-    turnstate.hpp
+    turnstate.hpp \
+    workqueue.hpp
 
 RESOURCES += \
     resources.qrc
@@ -0,0 +1,307 @@
+#include <algorithm>
+#include "alphabeta.hpp"
+#include "io.hpp"
+
+AlphaBeta::AlphaBeta(NodePtr node_,const unsigned int numThreads_,QObject* const parent) :
+  QObject(parent),
+  node(std::move(node_)),
+  numThreads(std::max(1u,numThreads_)),
+  table(TABLE_SIZE,Entry{0,-1,0,EXACT,0}),
+  stopRequested(false),
+  searching_(false),
+  numNodes(0)
+{
+  assert(!node->inSetup());
+}
+
+AlphaBeta::~AlphaBeta()
+{
+  stop();
+}
+
+void AlphaBeta::start(const qint64 milliseconds,const int maxDepth)
+{
+  stop();
+  stopRequested=false;
+  searching_=true;
+  numNodes=0;
+  startTime=std::chrono::steady_clock::now();
+  deadline=startTime+std::chrono::milliseconds(milliseconds);
+  thread=std::thread(&AlphaBeta::run,this,maxDepth);
+}
+
+void AlphaBeta::stop()
+{
+  stopRequested=true;
+  if (thread.joinable())
+    thread.join();
+}
+
+bool AlphaBeta::searching() const
+{
+  return searching_;
+}
+
+int AlphaBeta::evaluate(const GameState& gameState)
+{
+  static const std::array<int,NUM_PIECE_TYPES> pieceValues={100,250,300,450,800,1200};
+  int scores[NUM_SIDES]={0,0};
+  for (SquareIndex square=FIRST_SQUARE;square<NUM_SQUARES;increment(square)) {
+    const auto piece=gameState.squarePieces[square];
+    if (piece!=NO_PIECE) {
+      const auto side=toSide(piece);
+      const auto pieceType=toPieceType(piece);
+      scores[side]+=pieceValues[pieceType];
+      if (pieceType==WINNING_PIECE_TYPE) {
+        const auto progress=(side==FIRST_SIDE ? toRank(square) : NUM_RANKS-1-toRank(square));
+        scores[side]+=progress*progress*3;
+      }
+    }
+  }
+  for (const auto trap:getTrapSquares()) {
+    int guards[NUM_SIDES]={0,0};
+    for (const auto adjacentSquare:adjacentSquares(trap)) {
+      const auto piece=gameState.squarePieces[adjacentSquare];
+      if (piece!=NO_PIECE)
+        ++guards[toSide(piece)];
+    }
+    for (Side side=FIRST_SIDE;side<NUM_SIDES;increment(side))
+      scores[side]+=std::min(guards[side],2)*20;
+  }
+  const auto side=gameState.sideToMove;
+  return scores[side]-scores[otherSide(side)];
+}
+
+std::string AlphaBeta::toString(const std::vector<ExtendedSteps>& moves)
+{
+  std::string result;
+  for (const auto& move:moves) {
+    if (!result.empty())
+      result+=' ';
+    result+=::toString(move);
+    if (resultingState(move).stepsAvailable>0)
+      result+=" pass";
+  }
+  return result;
+}
+
+TurnState::Hash AlphaBeta::stateHash(const GameState& gameState,const TurnState::Hash boardHash)
+{
+  auto result=boardHash;
+  const auto mix=[&result](const TurnState::Hash value) {
+    result^=value+0x9e3779b97f4a7c15ULL+(result<<6)+(result>>2);
+  };
+  mix(gameState.stepsAvailable);
+  mix(gameState.inPush);
+  mix(gameState.followupDestination+1);
+  for (const auto origin:gameState.followupOrigins)
+    mix(origin+NUM_SQUARES);
+  return result;
+}
+
+void AlphaBeta::run(const int maxDepth)
+{
+  std::vector<RootMove> rootMoves;
+  for (const auto& move:node->legalMoves()) {
+    GameState gameState(resultingState(move));
+    gameState.switchTurn();
+    rootMoves.push_back({move,gameState,-WIN_SCORE});
+  }
+
+  std::vector<ExtendedSteps> bestLine;
+  for (int depth=1;depth<=maxDepth && !rootMoves.empty() && !aborted();++depth) {
+    std::atomic<size_t> nextIndex(1);
+    std::atomic<int> alpha(-WIN_SCORE);
+    const auto searchRootMove=[&](RootMove& rootMove) {
+      const auto result=Node::goalOrElimination(rootMove.gameState);
+      if (result.endCondition!=NO_END)
+        rootMove.score=(result.winner==node->gameState.sideToMove ? WIN_SCORE-1 : -WIN_SCORE+1);
+      else
+        rootMove.score=-search(rootMove.gameState,depth-1,1,-WIN_SCORE,-alpha.load());
+      for (int current=alpha.load();rootMove.score>current && !alpha.compare_exchange_weak(current,rootMove.score););
+    };
+    searchRootMove(rootMoves.front());
+    Solver::runParallel(std::min<size_t>(numThreads,rootMoves.size()),[&] {
+      for (size_t index;(index=nextIndex++)<rootMoves.size();)
+        searchRootMove(rootMoves[index]);
+    });
+    if (stopRequested)
+      break;
+
+    std::stable_sort(rootMoves.begin(),rootMoves.end(),[](const RootMove& lhs,const RootMove& rhs) {
+      return lhs.score>rhs.score;
+    });
+    const auto& best=rootMoves.front();
+    bestLine=principalVariation(best,depth);
+    const auto elapsed=std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-startTime).count();
+    emit receivedLine(QString("info depth %1 score %2 nodes %3 time %4 pv %5").arg(depth).arg(best.score).arg(numNodes.load()).arg(elapsed/1000.0,0,'f',1).arg(QString::fromStdString(toString(bestLine))));
+    if (std::abs(best.score)>=WIN_SCORE-MAX_DEPTH)
+      break;
+  }
+
+  if (bestLine.empty() && !rootMoves.empty())
+    bestLine.emplace_back(rootMoves.front().move);
+  const auto bestMove=(bestLine.empty() ? QString() : QString::fromStdString(toString({bestLine.front()})));
+  emit receivedLine("bestmove "+bestMove);
+  searching_=false;
+  emit receivedBestMove(bestMove);
+}
+
+int AlphaBeta::search(const GameState& gameState,const int depth,const int ply,int alpha,const int beta)
+{
+  if (aborted())
+    return 0;
+  ++numNodes;
+  const auto hash=gameState.hash();
+  TurnState::Hash bestChild=0;
+  Entry entry;
+  if (probe(hash,entry)) {
+    bestChild=entry.bestChild;
+    const int score=fromTableScore(entry.score,ply);
+    if (entry.depth>=depth &&
+        (entry.bound==EXACT || (entry.bound==LOWER && score>=beta) || (entry.bound==UPPER && score<=alpha)))
+      return score;
+  }
+  if (depth==0)
+    return evaluate(gameState);
+
+  const int originalAlpha=alpha;
+  int bestScore=-WIN_SCORE;
+  TurnState::Hash bestHash=0;
+  const auto update=[&](const GameState& child,const int score) {
+    if (score>bestScore) {
+      bestScore=score;
+      bestHash=child.hash();
+      if (score>alpha)
+        alpha=score;
+    }
+    return alpha>=beta;
+  };
+  const auto terminalScore=[&](const GameState& child,int& score) {
+    const auto result=Node::goalOrElimination(child);
+    if (result.endCondition==NO_END)
+      return false;
+    score=(result.winner==gameState.sideToMove ? WIN_SCORE-ply-1 : -WIN_SCORE+ply+1);
+    return true;
+  };
+
+  bool anyMove=false;
+  std::vector<GameState> children;
+  forEachMove(gameState,[&](const GameState& resultingState) {
+    anyMove=true;
+    GameState child(resultingState);
+    child.switchTurn();
+    if (depth==1) {
+      int score;
+      if (!terminalScore(child,score))
+        score=-evaluate(child);
+      return update(child,score);
+    }
+    else {
+      children.emplace_back(std::move(child));
+      return false;
+    }
+  });
+  if (!anyMove)
+    return -WIN_SCORE+ply;
+
+  std::vector<std::pair<int,size_t> > order;
+  order.reserve(children.size());
+  for (size_t childIndex=0;childIndex<children.size();++childIndex) {
+    const auto& child=children[childIndex];
+    int priority=0;
+    if (bestChild!=0 && child.hash()==bestChild)
+      priority=WIN_SCORE;
+    else
+      priority=-evaluate(child);
+    order.emplace_back(priority,childIndex);
+  }
+  std::stable_sort(order.begin(),order.end(),[](const std::pair<int,size_t>& lhs,const std::pair<int,size_t>& rhs) {
+    return lhs.first>rhs.first;
+  });
+
+  for (const auto& ordered:order) {
+    const auto& child=children[ordered.second];
+    int score;
+    if (!terminalScore(child,score))
+      score=-search(child,depth-1,ply+1,-beta,-alpha);
+    if (stopRequested)
+      return 0;
+    if (update(child,score))
+      break;
+  }
+  store({hash,depth,toTableScore(bestScore,ply),bestScore<=originalAlpha ? UPPER : bestScore>=beta ? LOWER : EXACT,bestHash});
+  return bestScore;
+}
+
+// Win scores count plies from the root, so the table keeps them relative to the stored position instead.
+int AlphaBeta::toTableScore(const int score,const int ply)
+{
+  if (score>=WIN_SCORE-MAX_DEPTH)
+    return score+ply;
+  else if (score<=-WIN_SCORE+MAX_DEPTH)
+    return score-ply;
+  else
+    return score;
+}
+
+int AlphaBeta::fromTableScore(const int score,const int ply)
+{
+  if (score>=WIN_SCORE-MAX_DEPTH)
+    return score-ply;
+  else if (score<=-WIN_SCORE+MAX_DEPTH)
+    return score+ply;
+  else
+    return score;
+}
+
+bool AlphaBeta::probe(const TurnState::Hash hash,Entry& entry)
+{
+  const auto index=hash%TABLE_SIZE;
+  const std::lock_guard<std::mutex> lock(table_mutex[index%NUM_TABLE_LOCKS]);
+  entry=table[index];
+  return entry.hash==hash && entry.depth>=0;
+}
+
+void AlphaBeta::store(const Entry& entry)
+{
+  const auto index=entry.hash%TABLE_SIZE;
+  const std::lock_guard<std::mutex> lock(table_mutex[index%NUM_TABLE_LOCKS]);
+  auto& existing=table[index];
+  if (existing.hash!=entry.hash || existing.depth<=entry.depth)
+    existing=entry;
+}
+
+std::vector<ExtendedSteps> AlphaBeta::principalVariation(const RootMove& rootMove,const int depth)
+{
+  std::vector<ExtendedSteps> result{rootMove.move};
+  auto gameState=rootMove.gameState;
+  std::set<TurnState::Hash> seen{gameState.hash()};
+  for (int ply=1;ply<depth && Node::goalOrElimination(gameState).endCondition==NO_END;++ply) {
+    Entry entry;
+    if (!probe(gameState.hash(),entry) || entry.bestChild==0)
+      break;
+    const Node position(nullptr,ExtendedSteps(),gameState);
+    bool found=false;
+    for (const auto& move:position.legalMoves()) {
+      GameState child(resultingState(move));
+      child.switchTurn();
+      if (child.hash()==entry.bestChild) {
+        result.emplace_back(move);
+        gameState=child;
+        found=true;
+        break;
+      }
+    }
+    if (!found || !seen.insert(gameState.hash()).second)
+      break;
+  }
+  return result;
+}
+
+bool AlphaBeta::aborted()
+{
+  if (!stopRequested && (numNodes.load()&0xff)==0 && std::chrono::steady_clock::now()>=deadline)
+    stopRequested=true;
+  return stopRequested;
+}
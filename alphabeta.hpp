@@ -0,0 +1,91 @@
+#ifndef ALPHABETA_HPP
+#define ALPHABETA_HPP
+
+#include <atomic>
+#include <chrono>
+#include <unordered_set>
+#include <QObject>
+#include "solver.hpp"
+
+class AlphaBeta : public QObject {
+  Q_OBJECT
+public:
+  explicit AlphaBeta(NodePtr node_,const unsigned int numThreads_=Solver::defaultNumThreads(),QObject* const parent=nullptr);
+  ~AlphaBeta();
+  void start(const qint64 milliseconds,const int maxDepth=MAX_DEPTH);
+  void stop();
+  bool searching() const;
+  static int evaluate(const GameState& gameState);
+  static std::string toString(const std::vector<ExtendedSteps>& moves);
+
+  template<class Function>
+  static void forEachMove(const GameState& gameState,Function function)
+  {
+    std::unordered_set<TurnState::Hash> resultingBoards{gameState.hash()};
+    std::unordered_set<TurnState::Hash> visited;
+    bool done=false;
+    const std::function<void(const GameState&)> expand=[&](const GameState& state) {
+      const auto boardHash=state.hash();
+      if (!visited.insert(stateHash(state,boardHash)).second)
+        return;
+      if (!state.inPush && resultingBoards.insert(boardHash).second && function(state))
+        done=true;
+      if (state.stepsAvailable>0)
+        for (SquareIndex origin=FIRST_SQUARE;origin<NUM_SQUARES && !done;increment(origin))
+          if (state.squarePieces[origin]!=NO_PIECE)
+            forEachAdjacentSquare(origin,[&](const SquareIndex adjacentSquare) {
+              if (state.legalStep(origin,adjacentSquare)) {
+                GameState changedState(state);
+                changedState.takeStep(origin,adjacentSquare);
+                expand(changedState);
+              }
+              return done;
+            });
+    };
+    expand(gameState);
+  }
+
+  static constexpr int MAX_DEPTH=64;
+  static constexpr int WIN_SCORE=1000000;
+signals:
+  void receivedLine(const QString& line);
+  void receivedBestMove(const QString& move);
+private:
+  enum Bound {EXACT,LOWER,UPPER};
+  struct Entry {
+    TurnState::Hash hash;
+    int depth;
+    int score;
+    Bound bound;
+    TurnState::Hash bestChild;
+  };
+  struct RootMove {
+    ExtendedSteps move;
+    GameState gameState;
+    int score;
+  };
+
+  static TurnState::Hash stateHash(const GameState& gameState,const TurnState::Hash boardHash);
+  void run(const int maxDepth);
+  int search(const GameState& gameState,const int depth,const int ply,int alpha,const int beta);
+  static int toTableScore(const int score,const int ply);
+  static int fromTableScore(const int score,const int ply);
+  bool probe(const TurnState::Hash hash,Entry& entry);
+  void store(const Entry& entry);
+  std::vector<ExtendedSteps> principalVariation(const RootMove& rootMove,const int depth);
+  bool aborted();
+
+  static constexpr size_t TABLE_SIZE=1<<20;
+  static constexpr size_t NUM_TABLE_LOCKS=64;
+  const NodePtr node;
+  const unsigned int numThreads;
+  std::vector<Entry> table;
+  std::array<std::mutex,NUM_TABLE_LOCKS> table_mutex;
+  std::thread thread;
+  std::atomic<bool> stopRequested;
+  std::atomic<bool> searching_;
+  std::atomic<unsigned long long> numNodes;
+  std::chrono::steady_clock::time_point startTime,deadline;
+};
+
+#endif // ALPHABETA_HPP
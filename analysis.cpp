@@ -1,8 +1,5 @@
 #include <QApplication>
 #include <QScrollBar>
-#include <QLabel>
-#include <QPushButton>
-#include <QStyleOptionButton>
 #include <QContextMenuEvent>
 #include <QMenu>
 #include <QClipboard>
@@ -10,31 +7,25 @@
 #include "messagebox.hpp"
 #include "io.hpp"
 
-Analysis::Analysis(Globals& globals_,NodePtr node,const std::pair<Placements,ExtendedSteps>& partialMove,const CommandLine& commandLine,std::set<std::string>& passSynonyms_,QWidget* parent) :
+Analysis::Analysis(Globals& globals_,NodePtr node,const std::pair<Placements,ExtendedSteps>& partialMove,const CommandLine& commandLine,std::set<std::string>& passSynonyms_,const QString& cacheKey_,const AnalysisCache::Entry& cached_,QWidget* parent) :
   QWidget(parent,Qt::Window),
   globals(globals_),
   passSynonyms(passSynonyms_),
   process(this),
+  cacheKey(cacheKey_),
+  cached(cached_),
+  cacheOnly(false),
+  stopped(false),
   scrolledDown(true),
-  state(ROW_START),
   startPosition{node,partialMove.first,partialMove.second},
-  currentPosition(startPosition),
-  layout(this),
-  vBoxLayout(&scrollAreaChild),
-  lastHBoxLayout(nullptr),
-  lastLabel(nullptr)
+  model([this](const AnalysisModel::Line& line) {return delegate.lineWidth(line);}),
+  parser(new AnalysisParser(startPosition,passSynonyms,model)),
+  layout(this)
 {
-  layout.addWidget(&scrollArea);
-  scrollArea.setWidget(&scrollAreaChild);
-  scrollArea.setWidgetResizable(true);
-  vBoxLayout.addStretch();
-
-  connect(&process,&QProcess::readyReadStandardOutput,this,&Analysis::processStandardOutput);
+  connect(&process,&QProcess::readyReadStandardOutput,this,[this] {
+    processOutput(process.readAllStandardOutput());
+  });
   connect(&process,&QProcess::errorOccurred,this,[this](const QProcess::ProcessError error) {
-    if (isVisible())
-      setWindowTitle();
-    else
-      close();
     QString message;
     switch (error) {
       case QProcess::FailedToStart: message=tr("Failed to start."); break;
@@ -44,21 +35,18 @@ Analysis::Analysis(Globals& globals_,NodePtr node,const std::pair<Placements,Ext
       case QProcess::WriteError:    message=tr("Write error."); break;
       case QProcess::UnknownError:  message=tr("Unknown error."); break;
     };
-    MessageBox(QMessageBox::Critical,tr("Error analyzing"),message,QMessageBox::NoButton,this).exec();
+    reportError(message);
   });
-  connect(&process,static_cast<void (QProcess::*)(int,QProcess::ExitStatus)>(&QProcess::finished),this,[this] {
+  connect(&process,static_cast<void (QProcess::*)(int,QProcess::ExitStatus)>(&QProcess::finished),this,[this](const int exitCode,const QProcess::ExitStatus exitStatus) {
+    flushOutput();
+    if (exitStatus==QProcess::NormalExit && exitCode==0)
+      storeInCache();
     if (isVisible()) {
       QApplication::alert(this);
       setWindowTitle();
     }
   });
 
-  const auto verticalScrollBar=scrollArea.verticalScrollBar();
-  connect(verticalScrollBar,&QScrollBar::rangeChanged,this,[=] {
-    if (scrolledDown)
-      verticalScrollBar->setValue(verticalScrollBar->maximum());
-  });
-
   moveFile.open();
   QTextStream moveFileStream(&moveFile);
   moveFileStream<<commandLine.moves;
@@ -67,12 +55,126 @@ Analysis::Analysis(Globals& globals_,NodePtr node,const std::pair<Placements,Ext
   processStrings.append(commandLine.afterMoves);
   process.start(commandLine.executable,processStrings);
 
+  initialize();
+}
+
+Analysis::Analysis(Globals& globals_,NodePtr node,std::shared_ptr<Engine> engine_,std::set<std::string>& passSynonyms_,const QString& cacheKey_,const AnalysisCache::Entry& cached_,QWidget* parent) :
+  QWidget(parent,Qt::Window),
+  globals(globals_),
+  passSynonyms(passSynonyms_),
+  process(this),
+  engine(std::move(engine_)),
+  cacheKey(cacheKey_),
+  cached(cached_),
+  cacheOnly(false),
+  stopped(false),
+  scrolledDown(true),
+  startPosition{node,Placements(),ExtendedSteps()},
+  model([this](const AnalysisModel::Line& line) {return delegate.lineWidth(line);}),
+  parser(new AnalysisParser(startPosition,passSynonyms,model)),
+  layout(this)
+{
+  connect(engine.get(),&Engine::receivedLine,this,&Analysis::processLine);
+  connect(engine.get(),&Engine::receivedBestMove,this,[this] {
+    if (!stopped)
+      storeInCache();
+    if (isVisible()) {
+      QApplication::alert(this);
+      setWindowTitle();
+    }
+  });
+  connect(engine.get(),&Engine::failed,this,&Analysis::reportError);
+  engine->analyze(node);
+
+  initialize();
+}
+
+Analysis::Analysis(Globals& globals_,NodePtr node,const std::pair<Placements,ExtendedSteps>& partialMove,const AnalysisCache::Entry& cached_,std::set<std::string>& passSynonyms_,QWidget* parent) :
+  QWidget(parent,Qt::Window),
+  globals(globals_),
+  passSynonyms(passSynonyms_),
+  process(this),
+  cached(cached_),
+  cacheOnly(true),
+  stopped(false),
+  scrolledDown(true),
+  startPosition{node,partialMove.first,partialMove.second},
+  model([this](const AnalysisModel::Line& line) {return delegate.lineWidth(line);}),
+  parser(new AnalysisParser(startPosition,passSynonyms,model)),
+  layout(this)
+{
+  initialize();
+  flushOutput();
+}
+
+Analysis::Analysis(Globals& globals_,NodePtr node,std::unique_ptr<AlphaBeta> alphaBeta_,const qint64 milliseconds,QWidget* parent) :
+  QWidget(parent,Qt::Window),
+  globals(globals_),
+  process(this),
+  alphaBeta(std::move(alphaBeta_)),
+  cacheOnly(false),
+  stopped(false),
+  scrolledDown(true),
+  startPosition{node,Placements(),ExtendedSteps()},
+  model([this](const AnalysisModel::Line& line) {return delegate.lineWidth(line);}),
+  parser(new AnalysisParser(startPosition,passSynonyms,model)),
+  layout(this)
+{
+  connect(alphaBeta.get(),&AlphaBeta::receivedLine,this,&Analysis::processLine);
+  connect(alphaBeta.get(),&AlphaBeta::receivedBestMove,this,[this] {
+    if (isVisible()) {
+      QApplication::alert(this);
+      setWindowTitle();
+    }
+  });
+  alphaBeta->start(milliseconds);
+
+  initialize();
+}
+
+void Analysis::initialize()
+{
+  elapsedTimer.start();
+
+  parser->moveToThread(&parserThread);
+  connect(&parserThread,&QThread::finished,parser,&QObject::deleteLater);
+  parserThread.start();
+
+  layout.addWidget(&listView);
+  listView.setModel(&model);
+  listView.setItemDelegate(&delegate);
+  listView.setUniformItemSizes(true);
+  listView.setSelectionMode(QAbstractItemView::NoSelection);
+  listView.setHorizontalScrollMode(QAbstractItemView::ScrollPerPixel);
+  connect(&delegate,&AnalysisDelegate::clicked,this,[this](const Subnode& position) {
+    emit sendPosition(std::get<0>(position),{std::get<1>(position),std::get<2>(position)});
+  });
+
+  const auto verticalScrollBar=listView.verticalScrollBar();
+  connect(&model,&QAbstractItemModel::rowsAboutToBeInserted,this,[=] {
+    scrolledDown=(verticalScrollBar->value()==verticalScrollBar->maximum());
+  });
+  connect(&model,&QAbstractItemModel::rowsInserted,this,[this] {
+    if (scrolledDown)
+      listView.scrollToBottom();
+  });
+
   globals.settings.beginGroup("Analysis");
   const auto size=globals.settings.value("size").toSize();
   globals.settings.endGroup();
   if (size.isValid())
     resize(size);
 
+  if (!cached.empty()) {
+    if (engine!=nullptr || alphaBeta!=nullptr) {
+      for (const auto& line:QString::fromUtf8(cached.output).split('\n',Qt::SkipEmptyParts))
+        processLine(line);
+    }
+    else
+      processOutput(cached.output);
+    QMetaObject::invokeMethod(this,[this]{emit receivedOutput();},Qt::QueuedConnection);
+  }
+
   setWindowTitle();
   setAttribute(Qt::WA_DeleteOnClose);
 }
@@ -81,26 +183,64 @@ Analysis::~Analysis()
 {
   disconnect(&process,&QProcess::errorOccurred,this,nullptr);
   process.close();
+  parserThread.quit();
+  parserThread.wait();
+}
+
+bool Analysis::running() const
+{
+  if (alphaBeta!=nullptr)
+    return alphaBeta->searching();
+  return engine==nullptr ? process.state()!=QProcess::NotRunning : engine->searching();
+}
+
+void Analysis::reportError(const QString& message)
+{
+  if (isVisible())
+    setWindowTitle();
+  else
+    close();
+  emit failed();
+  MessageBox(QMessageBox::Critical,tr("Error analyzing"),message,QMessageBox::NoButton,this).exec();
+}
+
+void Analysis::storeInCache() const
+{
+  if (!cacheKey.isEmpty()) {
+    AnalysisCache::Entry entry;
+    if (engine==nullptr && alphaBeta==nullptr) {
+      // A refining run starts the command over, so its own output replaces the cached run that is shown before it.
+      entry.output=fullOutput().mid(cached.output.size());
+      entry.milliseconds=elapsedTimer.elapsed();
+    }
+    else {
+      entry.output=fullOutput();
+      entry.milliseconds=cached.milliseconds+elapsedTimer.elapsed();
+    }
+    AnalysisCache::store(cacheKey,entry);
+  }
 }
 
 void Analysis::setWindowTitle()
 {
-  const auto& startingNode=std::get<0>(currentPosition);
+  const auto& startingNode=std::get<0>(startPosition);
   auto position=startingNode->nextPlyString();
   if (startingNode->inSetup()) {
-    const auto& startingSetup=std::get<1>(currentPosition);
+    const auto& startingSetup=std::get<1>(startPosition);
     if (!startingSetup.empty())
       position+=' '+toString(startingSetup);
   }
   else {
-    const auto& startingMove=std::get<2>(currentPosition);
+    const auto& startingMove=std::get<2>(startPosition);
     if (!startingMove.empty())
       position+=' '+toString(startingMove);
   }
 
   QString windowTitle;
-  if (process.state()==QProcess::NotRunning) {
-    if (process.exitStatus()==QProcess::NormalExit)
+  if (cacheOnly)
+    windowTitle=tr("Cached analysis of %1 (%2 s)").arg(QString::fromStdString(position)).arg(cached.milliseconds/1000.0,0,'f',1);
+  else if (!running()) {
+    if (engine==nullptr && alphaBeta==nullptr ? process.exitStatus()==QProcess::NormalExit : !stopped)
       windowTitle=tr("Finished analyzing %1").arg(QString::fromStdString(position));
     else
       windowTitle=tr("Stopped analyzing %1").arg(QString::fromStdString(position));
@@ -110,128 +250,48 @@ void Analysis::setWindowTitle()
   QWidget::setWindowTitle(windowTitle);
 }
 
-void Analysis::processStandardOutput()
+void Analysis::processOutput(const QByteArray& additionalOutput)
 {
   QApplication::alert(this);
-  const auto verticalScrollBar=scrollArea.verticalScrollBar();
-  scrolledDown=(verticalScrollBar->value()==verticalScrollBar->maximum());
-
-  const auto additionalOutput=process.readAllStandardOutput();
   output+=additionalOutput;
-  ss.clear();
-  ss<<additionalOutput.toStdString();
-  std::string unprocessed;
-  while (true) {
-    auto c=ss.peek();
-    if (c==EOF) {
-      processPlainText(unprocessed);
-      break;
-    }
-    else if (isspace(c)) {
-      ss.get();
-      if (c=='\n' && state==PROCESSING_MOVES) {
-        state=ROW_START;
-        currentPosition=startPosition;
-      }
-      else
-        unprocessed+=c;
-    }
-    else {
-      auto& currentNode=std::get<0>(currentPosition);
-      const auto& currentSetup=std::get<1>(currentPosition);
-      auto& currentMove=std::get<2>(currentPosition);
-      const auto posBefore=ss.tellg();
-      const auto result=parseChunk(ss,currentPosition,true);
-      const auto& newPosition=std::get<0>(result);
-      auto chunk=std::get<1>(result);
-      bool action=(std::get<0>(newPosition)!=nullptr);
-
-      if (action)
-        currentPosition=newPosition;
-      else {
-        ss.clear();
-        ss.seekg(posBefore);
-        ss>>chunk;
-        if (passSynonyms.find(chunk)!=passSynonyms.end() && !currentNode->inSetup() && currentNode->legalMove(currentMove)==MoveLegality::LEGAL) {
-          currentNode=Node::makeMove(currentNode,currentMove,true);
-          assert(currentSetup.empty());
-          currentMove.clear();
-          action=true;
-        }
-      }
-
-      if (action) {
-        if (state==PROCESSING_MOVES) {
-          if (unprocessed!=" ")
-            lastHBoxLayout->insertSpacing(lastHBoxLayout->count()-1,10);
-          unprocessed.clear();
-        }
-        else {
-          processPlainText(unprocessed);
-          lastHBoxLayout=new QHBoxLayout();
-          vBoxLayout.insertLayout(vBoxLayout.count()-1,lastHBoxLayout);
-          assert(lastHBoxLayout->parent()!=nullptr);
-          lastHBoxLayout->setSpacing(0);
-          lastHBoxLayout->addStretch();
-        }
-        const auto pushButton=new QPushButton(QString::fromStdString(chunk));
-        lastHBoxLayout->insertWidget(lastHBoxLayout->count()-1,pushButton);
-        pushButton->installEventFilter(this);
-        pushButton->setFocusPolicy(Qt::TabFocus);
-        connect(pushButton,&QPushButton::pressed,pushButton,[pushButton]{pushButton->setFocus(Qt::MouseFocusReason);});
-        connect(pushButton,&QPushButton::clicked,this,[=] {
-          emit sendPosition(currentNode,{currentSetup,currentMove});
-        });
-        pushButton->setFont(monospace());
-
-        const auto textSize=pushButton->fontMetrics().size(Qt::TextShowMnemonic,pushButton->text());
-        QStyleOptionButton styleOptionButton;
-        styleOptionButton.initFrom(pushButton);
-        styleOptionButton.rect.setSize(textSize);
-        pushButton->setFixedSize(pushButton->style()->sizeFromContents(QStyle::CT_PushButton,&styleOptionButton,textSize,pushButton));
+  const auto parser_=parser;
+  QMetaObject::invokeMethod(parser_,[parser_,additionalOutput]{parser_->parse(additionalOutput);},Qt::QueuedConnection);
+  emit receivedOutput();
+}
 
-        state=PROCESSING_MOVES;
-      }
-      else {
-        unprocessed+=chunk;
-        if (state==PROCESSING_MOVES) {
-          std::string line;
-          getline(ss,line);
-          unprocessed+=line;
-          processPlainText(unprocessed);
-        }
-      }
-    }
+void Analysis::processLine(const QString& line)
+{
+  const auto text=line.toUtf8()+'\n';
+  const auto key=AnalysisModel::slot(line);
+  if (key.isEmpty())
+    output+=text;
+  else {
+    const auto slotLine=std::find_if(slotLines.begin(),slotLines.end(),[&key](const std::pair<QString,QByteArray>& entry) {
+      return entry.first==key;
+    });
+    if (slotLine==slotLines.end())
+      slotLines.emplace_back(key,text);
+    else
+      slotLine->second=text;
   }
+  QApplication::alert(this);
+  const auto parser_=parser;
+  QMetaObject::invokeMethod(parser_,[parser_,text]{parser_->parse(text);},Qt::QueuedConnection);
+  emit receivedOutput();
 }
 
-void Analysis::processPlainText(std::string& text)
+QByteArray Analysis::fullOutput() const
 {
-  if (!text.empty()) {
-    if (state==APPENDING_TEXT) {
-      assert(lastLabel!=nullptr);
-      lastLabel->setText(lastLabel->text()+QString::fromStdString(text));
-    }
-    else {
-      lastLabel=new QLabel(QString::fromStdString(text));
-      if (state==ROW_START) {
-        vBoxLayout.insertWidget(vBoxLayout.count()-1,lastLabel);
-        state=APPENDING_TEXT;
-      }
-      else {
-        assert(state==PROCESSING_MOVES);
-        assert(lastHBoxLayout!=nullptr);
-        lastHBoxLayout->insertWidget(lastHBoxLayout->count()-1,lastLabel);
-        state=ROW_START;
-        currentPosition=startPosition;
-      }
-      lastLabel->installEventFilter(this);
-      assert(lastLabel->parent()!=nullptr);
-      lastLabel->setFont(monospace());
-      lastLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
-    }
-    text.clear();
-  }
+  auto result=output;
+  for (const auto& slotLine:slotLines)
+    result+=slotLine.second;
+  return result;
+}
+
+void Analysis::flushOutput()
+{
+  const auto parser_=parser;
+  QMetaObject::invokeMethod(parser_,[parser_]{parser_->flush();},Qt::QueuedConnection);
 }
 
 bool Analysis::event(QEvent* event)
@@ -245,26 +305,6 @@ bool Analysis::event(QEvent* event)
   return QWidget::event(event);
 }
 
-bool Analysis::eventFilter(QObject* watched,QEvent* event)
-{
-  switch (event->type()) {
-    case QEvent::FocusIn:
-      if (const auto& pushButton=dynamic_cast<QPushButton*>(watched))
-        pushButton->click();
-    break;
-    case QEvent::ContextMenu: {
-      const auto& label=dynamic_cast<QLabel*>(watched);
-      if (label!=nullptr && !label->hasSelectedText()) {
-        contextMenuEvent(static_cast<QContextMenuEvent*>(event));
-        return true;
-      }
-    }
-    break;
-    default: break;
-  }
-  return QWidget::eventFilter(watched,event);
-}
-
 void Analysis::contextMenuEvent(QContextMenuEvent*)
 {
   auto menu=new QMenu(this);
@@ -272,17 +312,29 @@ void Analysis::contextMenuEvent(QContextMenuEvent*)
 
   const auto copyAll=new QAction(tr("Copy all to clipboard"),menu);
   connect(copyAll,&QAction::triggered,this,[this] {
-    QGuiApplication::clipboard()->setText(output);
+    QGuiApplication::clipboard()->setText(fullOutput());
   });
   menu->addAction(copyAll);
 
   const auto stop=new QAction(tr("Stop analysis"),menu);
-  if (process.state()==QProcess::NotRunning)
+  if (!running())
     stop->setEnabled(false);
   else
     connect(stop,&QAction::triggered,this,[this] {
-      disconnect(&process,&QProcess::errorOccurred,this,nullptr);
-      process.close();
+      if (alphaBeta!=nullptr) {
+        stopped=true;
+        alphaBeta->stop();
+        setWindowTitle();
+      }
+      else if (engine==nullptr) {
+        disconnect(&process,&QProcess::errorOccurred,this,nullptr);
+        process.close();
+      }
+      else {
+        stopped=true;
+        engine->stop();
+        setWindowTitle();
+      }
     });
   menu->addAction(stop);
 
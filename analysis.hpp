@@ -1,16 +1,19 @@
 #ifndef ANALYSIS_HPP
 #define ANALYSIS_HPP
 
-#include <sstream>
-class QHBoxLayout;
-class QLabel;
 #include <QWidget>
 #include <QProcess>
 #include <QTemporaryFile>
 #include <QVBoxLayout>
-#include <QScrollArea>
+#include <QListView>
+#include <QThread>
+#include <QElapsedTimer>
 #include "globals.hpp"
 #include "gamestate.hpp"
+#include "engine.hpp"
+#include "alphabeta.hpp"
+#include "analysismodel.hpp"
+#include "analysiscache.hpp"
 
 class Analysis : public QWidget {
   Q_OBJECT
@@ -20,40 +23,50 @@ public:
     QStringList beforeMoves,afterMoves;
   };
 
-  explicit Analysis(Globals& globals_,NodePtr node,const std::pair<Placements,ExtendedSteps>& partialMove,const CommandLine& commandLine,std::set<std::string>& passSynonyms_,QWidget* parent=nullptr);
+  explicit Analysis(Globals& globals_,NodePtr node,const std::pair<Placements,ExtendedSteps>& partialMove,const CommandLine& commandLine,std::set<std::string>& passSynonyms_,const QString& cacheKey_,const AnalysisCache::Entry& cached_,QWidget* parent=nullptr);
+  explicit Analysis(Globals& globals_,NodePtr node,std::shared_ptr<Engine> engine_,std::set<std::string>& passSynonyms_,const QString& cacheKey_,const AnalysisCache::Entry& cached_,QWidget* parent=nullptr);
+  explicit Analysis(Globals& globals_,NodePtr node,const std::pair<Placements,ExtendedSteps>& partialMove,const AnalysisCache::Entry& cached_,std::set<std::string>& passSynonyms_,QWidget* parent=nullptr);
+  explicit Analysis(Globals& globals_,NodePtr node,std::unique_ptr<AlphaBeta> alphaBeta_,const qint64 milliseconds,QWidget* parent=nullptr);
   ~Analysis();
+  bool running() const;
 private:
+  void initialize();
+  void reportError(const QString& message);
+  void storeInCache() const;
   void setWindowTitle();
-  void processStandardOutput();
-  void processPlainText(std::string& text);
+  void processOutput(const QByteArray& additionalOutput);
+  void processLine(const QString& line);
+  QByteArray fullOutput() const;
+  void flushOutput();
   virtual bool event(QEvent* event) override;
-  virtual bool eventFilter(QObject* watched,QEvent* event) override;
   virtual void contextMenuEvent(QContextMenuEvent* event) override;
 
   Globals& globals;
   std::set<std::string> passSynonyms;
   QProcess process;
   QTemporaryFile moveFile;
+  std::shared_ptr<Engine> engine;
+  std::unique_ptr<AlphaBeta> alphaBeta;
+  const QString cacheKey;
+  const AnalysisCache::Entry cached;
+  const bool cacheOnly;
+  QElapsedTimer elapsedTimer;
+  bool stopped;
   QByteArray output;
-  std::stringstream ss;
+  std::vector<std::pair<QString,QByteArray> > slotLines;
   bool scrolledDown;
-  enum State {
-    ROW_START,
-    APPENDING_TEXT,
-    PROCESSING_MOVES
-  } state;
-  Subnode startPosition,currentPosition;
+  const Subnode startPosition;
+  AnalysisDelegate delegate;
+  AnalysisModel model;
+  QThread parserThread;
+  AnalysisParser* const parser;
 
   QVBoxLayout layout;
-    QScrollArea scrollArea;
-      QWidget scrollAreaChild;
-        QVBoxLayout vBoxLayout;
-          QHBoxLayout* lastHBoxLayout;
-          QLabel* lastLabel;
+    QListView listView;
 signals:
   void sendPosition(const NodePtr& node,const std::pair<Placements,ExtendedSteps>& partialMove);
-
-  friend class StartAnalysis;
+  void receivedOutput();
+  void failed();
 };
 
 #endif // ANALYSIS_HPP
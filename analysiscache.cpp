@@ -0,0 +1,89 @@
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDir>
+#include <QDataStream>
+#include "analysiscache.hpp"
+#include "io.hpp"
+
+std::map<QString,AnalysisCache::ExecutableVersion> AnalysisCache::executableHashes;
+std::mutex AnalysisCache::executableHashes_mutex;
+
+QString AnalysisCache::key(const NodePtr& node,const std::pair<Placements,ExtendedSteps>& partialMove,const QString& executable,const QStringList& arguments,const bool aei)
+{
+  QString path=executable;
+  if (!QFileInfo(path).isAbsolute()) {
+    const auto found=QStandardPaths::findExecutable(path);
+    if (!found.isEmpty())
+      path=found;
+  }
+  const QFileInfo fileInfo(path);
+  if (fileInfo.exists())
+    path=fileInfo.canonicalFilePath();
+
+  QByteArray material;
+  QDataStream stream(&material,QIODevice::WriteOnly);
+  stream<<quint64(node->gameState.hash())<<node->inSetup();
+  stream<<QString::fromStdString(node->inSetup() ? toString(partialMove.first) : toString(partialMove.second));
+  stream<<path<<executableHash(path)<<arguments<<aei;
+  return QCryptographicHash::hash(material,QCryptographicHash::Sha1).toHex();
+}
+
+AnalysisCache::Entry AnalysisCache::load(const QString& key)
+{
+  Entry entry;
+  QFile file(directory()+'/'+key);
+  if (file.open(QIODevice::ReadOnly)) {
+    QDataStream stream(&file);
+    quint32 version;
+    stream>>version;
+    if (version==VERSION) {
+      Entry read;
+      stream>>read.output>>read.milliseconds;
+      if (stream.status()==QDataStream::Ok)
+        entry=read;
+    }
+  }
+  return entry;
+}
+
+void AnalysisCache::store(const QString& key,const Entry& entry)
+{
+  const auto path=directory();
+  if (path.isEmpty() || !QDir().mkpath(path))
+    return;
+  QSaveFile file(path+'/'+key);
+  if (file.open(QIODevice::WriteOnly)) {
+    QDataStream stream(&file);
+    stream<<VERSION<<entry.output<<entry.milliseconds;
+    file.commit();
+  }
+}
+
+QString AnalysisCache::directory()
+{
+  const auto cacheLocation=QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  return cacheLocation.isEmpty() ? cacheLocation : cacheLocation+"/analysis";
+}
+
+QByteArray AnalysisCache::executableHash(const QString& path)
+{
+  const QFileInfo fileInfo(path);
+  if (!fileInfo.isFile())
+    return QByteArray();
+  const auto lastModified=fileInfo.lastModified();
+  const auto size=fileInfo.size();
+
+  std::lock_guard<std::mutex> lock(executableHashes_mutex);
+  auto& version=executableHashes[path];
+  if (version.hash.isEmpty() || version.lastModified!=lastModified || version.size!=size) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+      return QByteArray();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(&file);
+    version={lastModified,size,hash.result()};
+  }
+  return version.hash;
+}
@@ -0,0 +1,39 @@
+#ifndef ANALYSISCACHE_HPP
+#define ANALYSISCACHE_HPP
+
+#include <map>
+#include <mutex>
+#include <QByteArray>
+#include <QDateTime>
+#include <QStringList>
+#include "node.hpp"
+
+class AnalysisCache {
+public:
+  struct Entry {
+    QByteArray output;
+    qint64 milliseconds;
+
+    Entry() : milliseconds(0) {}
+    bool empty() const {return output.isEmpty();}
+  };
+
+  static QString key(const NodePtr& node,const std::pair<Placements,ExtendedSteps>& partialMove,const QString& executable,const QStringList& arguments,const bool aei);
+  static Entry load(const QString& key);
+  static void store(const QString& key,const Entry& entry);
+private:
+  static constexpr quint32 VERSION=1;
+
+  static QString directory();
+  static QByteArray executableHash(const QString& path);
+
+  struct ExecutableVersion {
+    QDateTime lastModified;
+    qint64 size;
+    QByteArray hash;
+  };
+  static std::map<QString,ExecutableVersion> executableHashes;
+  static std::mutex executableHashes_mutex;
+};
+
+#endif // ANALYSISCACHE_HPP
@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <sstream>
+#include <QApplication>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QStyleOptionButton>
+#include <QAbstractItemView>
+#include "analysismodel.hpp"
+#include "io.hpp"
+
+AnalysisModel::AnalysisModel(std::function<int(const Line&)> lineWidth_,QObject* const parent) :
+  QAbstractListModel(parent),
+  lineWidth(std::move(lineWidth_)),
+  maxLineWidth_(0)
+{
+}
+
+void AnalysisModel::update(const Update& entries)
+{
+  const auto oldMaxLineWidth=maxLineWidth_;
+  for (const auto& entry:entries) {
+    const auto& key=entry.first;
+    const auto& newLine=entry.second;
+    maxLineWidth_=std::max(maxLineWidth_,lineWidth(newLine));
+    const auto slotRow=(key.isEmpty() ? slotRows.end() : slotRows.find(key));
+    if (slotRow!=slotRows.end()) {
+      lines[slotRow->second]=newLine;
+      const auto changed=index(slotRow->second);
+      emit dataChanged(changed,changed);
+    }
+    else {
+      const int row=lines.size();
+      beginInsertRows(QModelIndex(),row,row);
+      lines.emplace_back(newLine);
+      if (!key.isEmpty())
+        slotRows.emplace(key,row);
+      endInsertRows();
+    }
+  }
+  // Views with uniform item sizes only pick up the new width on a relayout.
+  if (maxLineWidth_>oldMaxLineWidth) {
+    emit layoutAboutToBeChanged();
+    emit layoutChanged();
+  }
+}
+
+const AnalysisModel::Line& AnalysisModel::line(const int row) const
+{
+  return lines[row];
+}
+
+int AnalysisModel::maxLineWidth() const
+{
+  return maxLineWidth_;
+}
+
+QString AnalysisModel::toString(const Line& line)
+{
+  QString result;
+  for (const auto& segment:line) {
+    if (segment.gap || (segment.move && !result.isEmpty() && !result.endsWith(' ')))
+      result+=' ';
+    result+=segment.text;
+  }
+  return result;
+}
+
+QString AnalysisModel::slot(const QString& text)
+{
+  if (!text.startsWith("info "))
+    return QString();
+  const auto type=text.section(' ',1,1,QString::SectionSkipEmpty);
+  if (type=="multipv")
+    return type+' '+text.section(' ',2,2,QString::SectionSkipEmpty);
+  else if (type=="pv")
+    return "multipv 1";
+  else
+    return type;
+}
+
+int AnalysisModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : lines.size();
+}
+
+QVariant AnalysisModel::data(const QModelIndex& index,const int role) const
+{
+  if (index.isValid() && (role==Qt::DisplayRole || role==Qt::ToolTipRole))
+    return toString(lines[index.row()]);
+  return QVariant();
+}
+
+AnalysisParser::AnalysisParser(const Subnode& startPosition_,const std::set<std::string>& passSynonyms_,AnalysisModel& model_) :
+  startNode(std::get<0>(startPosition_)),
+  startPosition(Node::reroot(startNode),std::get<1>(startPosition_),std::get<2>(startPosition_)),
+  passSynonyms(passSynonyms_),
+  model(model_),
+  frameTimer(this)
+{
+  frameTimer.setSingleShot(true);
+  frameTimer.setInterval(FRAME_INTERVAL);
+  connect(&frameTimer,&QTimer::timeout,this,&AnalysisParser::send);
+}
+
+void AnalysisParser::parse(const QByteArray& data)
+{
+  buffer+=data;
+  for (int lineEnd;(lineEnd=buffer.indexOf('\n'))>=0;) {
+    auto text=buffer.left(lineEnd);
+    buffer.remove(0,lineEnd+1);
+    if (text.endsWith('\r'))
+      text.chop(1);
+    add(text);
+  }
+  if (!pending.empty() && !frameTimer.isActive())
+    frameTimer.start();
+}
+
+void AnalysisParser::flush()
+{
+  if (!buffer.isEmpty()) {
+    add(buffer);
+    buffer.clear();
+  }
+  frameTimer.stop();
+  send();
+}
+
+void AnalysisParser::add(const QByteArray& text)
+{
+  const auto key=AnalysisModel::slot(QString::fromUtf8(text));
+  if (!key.isEmpty())
+    for (auto& entry:pending)
+      if (entry.first==key) {
+        entry.second=text;
+        return;
+      }
+  pending.emplace_back(key,text);
+}
+
+void AnalysisParser::send()
+{
+  if (!pending.empty()) {
+    AnalysisModel::Update entries;
+    for (const auto& entry:pending)
+      entries.emplace_back(entry.first,parseLine(entry.second.toStdString()));
+    pending.clear();
+    const auto model_=&model;
+    const auto startNode_=startNode;
+    QMetaObject::invokeMethod(model_,[model_,startNode_,entries]() mutable {
+      resolve(startNode_,entries);
+      model_->update(entries);
+    },Qt::QueuedConnection);
+  }
+}
+
+void AnalysisParser::locate(AnalysisModel::Segment& segment,const NodePtr& node) const
+{
+  // Moves are parsed into a copy of the game, so the segment records how to reach its position from the start instead.
+  auto ancestor=std::get<0>(startPosition);
+  auto descendant=node;
+  segment.numTakebacks=0;
+  segment.plies.clear();
+  while (ancestor!=descendant) {
+    if (ancestor->depth>=descendant->depth) {
+      ancestor=ancestor->previousNode;
+      ++segment.numTakebacks;
+    }
+    else {
+      if (descendant->previousNode->inSetup())
+        segment.plies.emplace_back(descendant->playedPlacements(),ExtendedSteps());
+      else
+        segment.plies.emplace_back(Placements(),descendant->move);
+      descendant=descendant->previousNode;
+    }
+  }
+  std::reverse(segment.plies.begin(),segment.plies.end());
+}
+
+void AnalysisParser::resolve(const NodePtr& startNode,AnalysisModel::Update& entries)
+{
+  for (auto& entry:entries) {
+    int numTakebacks=-1;
+    std::vector<NodePtr> nodes;
+    AnalysisModel::Plies previousPlies;
+    for (auto& segment:entry.second) {
+      if (!segment.move)
+        continue;
+      size_t numShared=0;
+      if (segment.numTakebacks!=numTakebacks) {
+        numTakebacks=segment.numTakebacks;
+        auto node=startNode;
+        for (int takeback=0;takeback<numTakebacks;++takeback)
+          node=node->previousNode;
+        nodes.assign(1,node);
+      }
+      else
+        while (numShared<previousPlies.size() && numShared<segment.plies.size() && segment.plies[numShared]==previousPlies[numShared])
+          ++numShared;
+      nodes.resize(numShared+1);
+      for (auto ply=segment.plies.begin()+numShared;ply!=segment.plies.end();++ply) {
+        const auto node=nodes.back();
+        nodes.emplace_back(node->inSetup() ? Node::addSetup(node,ply->first,true) : Node::makeMove(node,ply->second,true));
+      }
+      std::get<0>(segment.position)=nodes.back();
+      previousPlies=std::move(segment.plies);
+      segment.plies.clear();
+    }
+  }
+}
+
+AnalysisModel::Line AnalysisParser::parseLine(const std::string& text) const
+{
+  AnalysisModel::Line result;
+  std::stringstream ss(text);
+  Subnode currentPosition=startPosition;
+  std::string unprocessed;
+  bool processingMoves=false;
+  const auto addText=[&] {
+    if (!unprocessed.empty()) {
+      result.push_back({QString::fromStdString(unprocessed),false,false,Subnode(),0,AnalysisModel::Plies()});
+      unprocessed.clear();
+    }
+  };
+  while (true) {
+    const auto c=ss.peek();
+    if (c==EOF) {
+      addText();
+      break;
+    }
+    else if (isspace(c)) {
+      ss.get();
+      unprocessed+=char(c);
+    }
+    else {
+      auto& currentNode=std::get<0>(currentPosition);
+      auto& currentMove=std::get<2>(currentPosition);
+      const auto posBefore=ss.tellg();
+      const auto parsed=parseChunk(ss,currentPosition,true);
+      const auto& newPosition=std::get<0>(parsed);
+      auto chunk=std::get<1>(parsed);
+      bool action=(std::get<0>(newPosition)!=nullptr);
+
+      if (action)
+        currentPosition=newPosition;
+      else {
+        ss.clear();
+        ss.seekg(posBefore);
+        ss>>chunk;
+        if (passSynonyms.find(chunk)!=passSynonyms.end() && !currentNode->inSetup() && currentNode->legalMove(currentMove)==MoveLegality::LEGAL) {
+          currentNode=Node::makeMove(currentNode,currentMove,true);
+          currentMove.clear();
+          action=true;
+        }
+      }
+
+      if (action) {
+        bool gap=false;
+        if (processingMoves) {
+          gap=(unprocessed!=" ");
+          unprocessed.clear();
+        }
+        else
+          addText();
+        result.push_back({QString::fromStdString(chunk),true,gap,Subnode(nullptr,std::get<1>(currentPosition),std::get<2>(currentPosition)),0,AnalysisModel::Plies()});
+        locate(result.back(),currentNode);
+        processingMoves=true;
+      }
+      else {
+        unprocessed+=chunk;
+        if (processingMoves) {
+          std::string line;
+          getline(ss,line);
+          unprocessed+=line;
+          addText();
+          processingMoves=false;
+          currentPosition=startPosition;
+        }
+      }
+    }
+  }
+  return result;
+}
+
+AnalysisDelegate::AnalysisDelegate(QObject* const parent) :
+  QStyledItemDelegate(parent),
+  font(monospace()),
+  fontMetrics(font),
+  currentSegment(0)
+{
+}
+
+int AnalysisDelegate::lineWidth(const AnalysisModel::Line& line) const
+{
+  int result=0;
+  for (const auto& segment:line)
+    result+=(segment.gap ? GAP : 0)+segmentWidth(segment);
+  return result;
+}
+
+int AnalysisDelegate::segmentWidth(const AnalysisModel::Segment& segment) const
+{
+  const auto textWidth=fontMetrics.size(Qt::TextExpandTabs,segment.text).width();
+  return segment.move ? textWidth+2*MARGIN : textWidth;
+}
+
+void AnalysisDelegate::paint(QPainter* painter,const QStyleOptionViewItem& option,const QModelIndex& index) const
+{
+  const auto& line=static_cast<const AnalysisModel*>(index.model())->line(index.row());
+  const auto style=(option.widget==nullptr ? QApplication::style() : option.widget->style());
+  painter->save();
+  painter->setFont(font);
+  int x=option.rect.left();
+  for (size_t segmentIndex=0;segmentIndex<line.size();++segmentIndex) {
+    const auto& segment=line[segmentIndex];
+    if (segment.gap)
+      x+=GAP;
+    const QRect rect(x,option.rect.top(),segmentWidth(segment),option.rect.height());
+    if (segment.move) {
+      QStyleOptionButton styleOptionButton;
+      styleOptionButton.rect=rect;
+      styleOptionButton.text=segment.text;
+      styleOptionButton.fontMetrics=fontMetrics;
+      styleOptionButton.palette=option.palette;
+      styleOptionButton.state=QStyle::State_Enabled;
+      if (currentIndex==index && currentSegment==segmentIndex)
+        styleOptionButton.state|=QStyle::State_Sunken|QStyle::State_HasFocus;
+      else
+        styleOptionButton.state|=QStyle::State_Raised;
+      style->drawControl(QStyle::CE_PushButton,&styleOptionButton,painter,option.widget);
+    }
+    else
+      painter->drawText(rect,Qt::AlignLeft|Qt::AlignVCenter|Qt::TextExpandTabs,segment.text);
+    x+=rect.width();
+  }
+  painter->restore();
+}
+
+QSize AnalysisDelegate::sizeHint(const QStyleOptionViewItem&,const QModelIndex& index) const
+{
+  return QSize(static_cast<const AnalysisModel*>(index.model())->maxLineWidth(),fontMetrics.height()+2*MARGIN);
+}
+
+bool AnalysisDelegate::editorEvent(QEvent* event,QAbstractItemModel* model,const QStyleOptionViewItem& option,const QModelIndex& index)
+{
+  if (event->type()==QEvent::MouseButtonRelease) {
+    const auto mouseEvent=static_cast<QMouseEvent*>(event);
+    if (mouseEvent->button()==Qt::LeftButton) {
+      const auto& line=static_cast<const AnalysisModel*>(model)->line(index.row());
+      int x=option.rect.left();
+      for (size_t segmentIndex=0;segmentIndex<line.size();++segmentIndex) {
+        const auto& segment=line[segmentIndex];
+        if (segment.gap)
+          x+=GAP;
+        const auto width=segmentWidth(segment);
+        if (segment.move && mouseEvent->x()>=x && mouseEvent->x()<x+width) {
+          currentIndex=index;
+          currentSegment=segmentIndex;
+          if (const auto view=qobject_cast<const QAbstractItemView*>(option.widget))
+            view->viewport()->update();
+          emit clicked(segment.position);
+          return true;
+        }
+        x+=width;
+      }
+    }
+  }
+  return QStyledItemDelegate::editorEvent(event,model,option,index);
+}
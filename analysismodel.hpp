@@ -0,0 +1,87 @@
+#ifndef ANALYSISMODEL_HPP
+#define ANALYSISMODEL_HPP
+
+#include <functional>
+#include <map>
+#include <QAbstractListModel>
+#include <QTimer>
+#include <QStyledItemDelegate>
+#include <QFontMetrics>
+#include "def.hpp"
+
+class AnalysisModel : public QAbstractListModel {
+  Q_OBJECT
+public:
+  typedef std::vector<std::pair<Placements,ExtendedSteps> > Plies;
+  struct Segment {
+    QString text;
+    bool move;
+    bool gap;
+    Subnode position;
+    int numTakebacks;
+    Plies plies;
+  };
+  typedef std::vector<Segment> Line;
+  typedef std::vector<std::pair<QString,Line> > Update;
+
+  explicit AnalysisModel(std::function<int(const Line&)> lineWidth_,QObject* const parent=nullptr);
+  void update(const Update& entries);
+  const Line& line(const int row) const;
+  int maxLineWidth() const;
+  static QString toString(const Line& line);
+  static QString slot(const QString& text);
+
+  virtual int rowCount(const QModelIndex& parent=QModelIndex()) const override;
+  virtual QVariant data(const QModelIndex& index,const int role) const override;
+private:
+  const std::function<int(const Line&)> lineWidth;
+  std::vector<Line> lines;
+  std::map<QString,int> slotRows;
+  int maxLineWidth_;
+};
+
+class AnalysisParser : public QObject {
+public:
+  AnalysisParser(const Subnode& startPosition_,const std::set<std::string>& passSynonyms_,AnalysisModel& model_);
+  void parse(const QByteArray& data);
+  void flush();
+private:
+  void add(const QByteArray& text);
+  void send();
+  AnalysisModel::Line parseLine(const std::string& text) const;
+  void locate(AnalysisModel::Segment& segment,const NodePtr& node) const;
+  static void resolve(const NodePtr& startNode,AnalysisModel::Update& entries);
+
+  static constexpr int FRAME_INTERVAL=100;
+
+  const NodePtr startNode;
+  const Subnode startPosition;
+  const std::set<std::string> passSynonyms;
+  AnalysisModel& model;
+  QByteArray buffer;
+  std::vector<std::pair<QString,QByteArray> > pending;
+  QTimer frameTimer;
+};
+
+class AnalysisDelegate : public QStyledItemDelegate {
+  Q_OBJECT
+public:
+  explicit AnalysisDelegate(QObject* const parent=nullptr);
+  int lineWidth(const AnalysisModel::Line& line) const;
+  virtual void paint(QPainter* painter,const QStyleOptionViewItem& option,const QModelIndex& index) const override;
+  virtual QSize sizeHint(const QStyleOptionViewItem& option,const QModelIndex& index) const override;
+  virtual bool editorEvent(QEvent* event,QAbstractItemModel* model,const QStyleOptionViewItem& option,const QModelIndex& index) override;
+private:
+  int segmentWidth(const AnalysisModel::Segment& segment) const;
+
+  static constexpr int MARGIN=4;
+  static constexpr int GAP=10;
+  const QFont font;
+  const QFontMetrics fontMetrics;
+  QPersistentModelIndex currentIndex;
+  size_t currentSegment;
+signals:
+  void clicked(const Subnode& position);
+};
+
+#endif // ANALYSISMODEL_HPP
@@ -124,7 +124,7 @@ std::unique_ptr<::ASIP> Arimaa_com<ASIP2>::getGame(QNetworkReply& networkReply)
   mostRecentData.insert("gsurl",gsurl);
   writeLocker.unlock();
 
-  return ASIP::getGame();
+  return ASIP::getGame(networkReply.property("role").toString());
 }
 
 template<class Base>
@@ -1,6 +1,9 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
+#include <QSet>
 #include "asip.hpp"
+#include "pollscheduler.hpp"
+#include "sessionlog.hpp"
 #include "io.hpp"
 #include "asip1.hpp"
 
@@ -9,8 +12,11 @@ ASIP::ASIP(QNetworkAccessManager& networkAccessManager_,const QString& serverURL
   networkAccessManager(networkAccessManager_),
   mostRecentData(std::move(startingData)),
   server(getNetworkRequest(serverURL)),
-  gameStateReply(nullptr)
+  gameStateReply(nullptr),
+  seated(false)
 {
+  entryTimes.fill(-1);
+  publishState();
 }
 
 ASIP::Data ASIP::processReply(QNetworkReply& networkReply)
@@ -20,8 +26,13 @@ ASIP::Data ASIP::processReply(QNetworkReply& networkReply)
   runtime_assert(networkReply.error()==QNetworkReply::NoError,networkReply.errorString());
   const Status oldStatus=getStatus();
   const auto rawData=networkReply.readAll();
+  if (const auto sessionLog=SessionLog::current())
+    sessionLog->logReply(networkReply,rawData);
   const auto replyData=getReplyData(rawData);
-  updateCache(replyData);
+  const auto action=networkReply.property("action");
+  updateCache(replyData,action=="updategamestate");
+  if (action=="reserveseat" || action=="newgame")
+    entryStart=networkReply.property("post_time").toDateTime();
   timeEstimator.add(networkReply.property("post_time").toDateTime(),lastReplyTime,instantResponse(networkReply),replyData.value("timeonserver"));
   const auto error=replyData.find("error");
   if (error!=replyData.end())
@@ -157,18 +168,22 @@ std::vector<ASIP::GameInfo> ASIP::getGameList(QNetworkReply& networkReply,const
 std::unique_ptr<ASIP> ASIP::getGame(QNetworkReply& networkReply)
 {
   processReply(networkReply);
-  return getGame();
+  return getGame(networkReply.property("role").toString());
 }
 
-std::unique_ptr<ASIP> ASIP::getGame() const
+std::unique_ptr<ASIP> ASIP::getGame(const QString& role) const
 {
   QReadLocker readLocker(&mostRecentData_mutex);
   auto startingData=mostRecentData;
   readLocker.unlock();
   startingData.remove("sid");
+  // Taken from the request, since seats may be reserved in other roles at the same time.
+  startingData.insert("role",role);
 
   auto game=create(networkAccessManager,mostRecentData.value("gsurl").toString(),nullptr,startingData);
   connect(game.get(),&ASIP::statusChanged,this,&ASIP::childStatusChanged);
+  game->entryStart=entryStart;
+  game->markEntryPhase(SEAT_RESERVED);
   return game;
 }
 
@@ -186,57 +201,55 @@ QNetworkReply* ASIP::gameListAction(const QString& action,const ASIP::GameListCa
   return networkReply;
 }
 
+std::shared_ptr<const ASIP::SessionState> ASIP::currentState() const
+{
+  return std::atomic_load(&sessionState);
+}
+
 bool ASIP::isEqualGame(const ASIP& otherGame) const
 {
   if (serverURL()!=otherGame.serverURL())
     return false;
-  const QReadLocker readLocker(&mostRecentData_mutex);
-  const QReadLocker otherReadLocker(&otherGame.mostRecentData_mutex);
-  return mostRecentData.value("grid")==otherGame.mostRecentData.value("grid") &&
-         mostRecentData.value("tid")==otherGame.mostRecentData.value("tid");
+  const auto state=currentState();
+  const auto otherState=otherGame.currentState();
+  return state->grid==otherState->grid && state->tid==otherState->tid;
 }
 
 Side ASIP::role() const
 {
-  const QReadLocker readLocker(&mostRecentData_mutex);
-  return toSide(get<QString>("role")[0].toLatin1());
+  return currentState()->role;
 }
 
 bool ASIP::gameStateAvailable() const
 {
-  const QReadLocker readLocker(&mostRecentData_mutex);
-  return mostRecentData.contains("auth");
+  return !currentState()->auth.isEmpty();
 }
 
 ASIP::Status ASIP::getStatus() const
 {
-  const QReadLocker readLocker(&mostRecentData_mutex);
-  if (mostRecentData.contains("result"))
-    return FINISHED;
-  else if (mostRecentData.contains("starttime"))
-    return LIVE;
-  else if (mostRecentData.value("canstart")==1)
-    return UNSTARTED;
-  else
-    return OPEN;
+  return currentState()->status;
 }
 
 Side ASIP::sideToMove() const
 {
-  const QReadLocker readLocker(&mostRecentData_mutex);
-  return toSide(get<QString>("turn")[0].toLatin1());
+  return currentState()->turn;
 }
 
-std::tuple<GameTree,size_t,bool> ASIP::getMoves(NodePtr root) const
+QString ASIP::fullText(const TranscriptPtr& transcript)
 {
-  const QReadLocker readLocker(&mostRecentData_mutex);
-  return toTree(get<QString>("moves").toStdString(),std::move(root));
+  std::vector<const QString*> segments;
+  for (auto current=transcript.get();current!=nullptr;current=current->earlier.get())
+    segments.emplace_back(&current->segment);
+  QString result;
+  result.reserve(transcript==nullptr ? 0 : transcript->size);
+  for (auto segment=segments.rbegin();segment!=segments.rend();++segment)
+    result+=**segment;
+  return result;
 }
 
 std::array<QString,NUM_SIDES> ASIP::getAnnotatedPlayers() const
 {
-  const QReadLocker readLocker(&mostRecentData_mutex);
-  return {mostRecentData.value("wplayer").toString(),mostRecentData.value("bplayer").toString()};
+  return currentState()->players;
 }
 
 std::array<QString,NUM_SIDES> ASIP::getPlayers() const
@@ -251,46 +264,35 @@ std::array<QString,NUM_SIDES> ASIP::getPlayers() const
 
 Result ASIP::getResult() const
 {
-  const QReadLocker readLocker(&mostRecentData_mutex);
-  const auto result=mostRecentData.value("result").toString().toStdString();
-  if (result.size()>=2)
-    return {toSide(result[0]),toEndCondition(result[1])};
-  else
-    return {NO_SIDE,NO_END};
+  return currentState()->result;
 }
 
 std::array<std::array<qint64,3>,NUM_SIDES> ASIP::getTimes() const
 {
-  QReadLocker readLocker(&mostRecentData_mutex);
-  const Side sideToMove_=sideToMove();
+  const auto state=currentState();
+  const Side sideToMove_=state->turn;
   runtime_assert(sideToMove_!=NO_SIDE,"No side to move.");
-  const auto status=getStatus();
-  const auto moveTime=mostRecentData.value("tcmove").toLongLong();
-  auto maxTurnTime=mostRecentData.value("tcturntime").toLongLong()*1000;
-  if (maxTurnTime==0)
-    maxTurnTime=std::numeric_limits<qint64>::max();
+  const auto status=state->status;
   std::array<std::array<qint64,3>,NUM_SIDES> result;
   for (Side side=FIRST_SIDE;side<NUM_SIDES;increment(side)) {
     auto&      hard=std::get<0>(result[side]);
     auto& potential=std::get<1>(result[side]);
     auto&      used=std::get<2>(result[side]);
 
-    const auto sideLetter=toLetter(side);
     qint64 moveTime_;
-    if (side==FIRST_SIDE && sideToMove_==SECOND_SIDE && get<int>("plycount")==1 && mostRecentData.contains("tcmoveorig"))
-      moveTime_=get<qint64>("tcmoveorig");
+    if (side==FIRST_SIDE && sideToMove_==SECOND_SIDE && state->plyCount==1 && state->originalMoveTime>=0)
+      moveTime_=state->originalMoveTime;
     else
-      moveTime_=moveTime;
-    const auto reserveString=QString("tc")+sideLetter+"reserve";
-    potential=(moveTime_+mostRecentData.value(mostRecentData.contains(reserveString+'2') ? reserveString+'2' : reserveString).toLongLong())*1000;
-    hard=std::min(maxTurnTime,potential);
-    used=mostRecentData.value(sideLetter+QString("used")).toLongLong()*1000;
+      moveTime_=state->moveTime;
+    potential=(moveTime_+state->reserves[side])*1000;
+    hard=std::min(state->maxTurnTime,potential);
+    used=state->used[side]*1000;
     if (side==sideToMove_) {
       if (status==LIVE)
         used+=timeEstimator.estimatedExtraTime();
       hard-=used;
       potential-=used;
-      if (status==LIVE && sideToMove_==role()) {
+      if (status==LIVE && sideToMove_==state->role) {
         const auto predictedSendLag=timeEstimator.estimatedRoundTripTime()/2;
         hard-=predictedSendLag;
         potential-=predictedSendLag;
@@ -302,14 +304,20 @@ std::array<std::array<qint64,3>,NUM_SIDES> ASIP::getTimes() const
 
 void ASIP::sit()
 {
-  QNetworkReply* sitReply=post(this,{{"action","sit"},dataPair("tid"),dataPair("grid")});
+  // Prefetched sessions arrive already seated.
+  if (seated)
+    return;
+  seated=true;
+  QNetworkReply* sitReply=post(this,{{"action","sit"},{"tid",currentState()->tid},{"grid",currentState()->grid}});
   connect(sitReply,&QNetworkReply::finished,this,[=] {
     try {
       processReply(*sitReply);
-      gameStateReply=post(this,{{"action","gamestate"},dataPair("sid")});
+      markEntryPhase(SEATED);
+      gameStateReply=post(this,{{"action","gamestate"},{"sid",currentState()->sid}});
       connect(gameStateReply,&QNetworkReply::finished,this,[=] {
         try {
           processReply(*gameStateReply);
+          markEntryPhase(STATE_RECEIVED);
           update(false);
         }
         catch (const std::exception& exception) {
@@ -326,11 +334,9 @@ void ASIP::sit()
 
 void ASIP::forceUpdate()
 {
-  if (gameStateReply!=nullptr) {
-    disconnect(gameStateReply,&QNetworkReply::finished,nullptr,nullptr);
-    gameStateReply->deleteLater();
-  }
-  gameStateReply=post(this,{{"action","gamestate"},dataPair("sid"),{"wait","0"},{"maxwait","0"}});
+  abortPoll();
+  PollScheduler::of(*this).remove(*this);
+  gameStateReply=post(this,{{"action","gamestate"},{"sid",currentState()->sid},{"wait","0"},{"maxwait","0"}});
   connect(gameStateReply,&QNetworkReply::finished,this,[=] {
     try {
       processReply(*gameStateReply);
@@ -379,36 +385,52 @@ void ASIP::leave()
     postAuthDependingAction("leave");
 }
 
+void ASIP::markEntryPhase(const EntryPhase entryPhase)
+{
+  if (entryTimes[entryPhase]<0 && entryStart.isValid())
+    entryTimes[entryPhase]=entryStart.msecsTo(QDateTime::currentDateTimeUtc());
+}
+
 void ASIP::update(const bool hardSynchronization)
 {
+  // Poll again before listeners redraw, so that the next round trip overlaps with their work.
+  gameStateReply=nullptr;
+  PollScheduler::of(*this).enqueue(*this);
   emit updated(hardSynchronization);
-  QReadLocker readLocker(&mostRecentData_mutex);
-  const auto oldMoves=mostRecentData.value("moves").toString();
-  const auto oldChat=mostRecentData.value("chat").toString();
-  readLocker.unlock();
-  gameStateReply=post(this,{{"action","updategamestate"},dataPair("sid"),{"wait","1"},dataPair("lastchange"),dataPair("moveslength"),dataPair("chatlength")});
+}
+
+void ASIP::poll(const bool wait)
+{
+  const auto state=currentState();
+  gameStateReply=post(this,{{"action","updategamestate"},{"sid",state->sid},{"wait",wait ? "1" : "0"},{"lastchange",state->lastChange},{"moveslength",state->movesLength},{"chatlength",state->chatLength}});
   connect(gameStateReply,&QNetworkReply::finished,this,[=] {
     try {
       processReply(*gameStateReply);
-      QWriteLocker writeLocker(&mostRecentData_mutex);
-      auto& newMoves=mostRecentData["moves"];
-      auto& newChat=mostRecentData["chat"];
-      newMoves=oldMoves+newMoves.toString();
-      newChat=oldChat+newChat.toString();
-      writeLocker.unlock();
       update(false);
     }
     catch (const std::exception& exception) {
       gameStateReply=nullptr;
+      PollScheduler::of(*this).remove(*this);
       emit error(exception);
     }
   });
 }
 
+void ASIP::abortPoll()
+{
+  if (gameStateReply!=nullptr) {
+    disconnect(gameStateReply,&QNetworkReply::finished,nullptr,nullptr);
+    gameStateReply->abort();
+    gameStateReply->deleteLater();
+    gameStateReply=nullptr;
+  }
+}
+
 void ASIP::postAuthDependingAction(const QString& action,const std::initializer_list<std::pair<QString,QString> >& extraItems)
 {
   const auto doAction=[=]{
-    std::vector<std::pair<QString,QString> > items={{"action",action},dataPair("sid"),dataPair("auth")};
+    const auto state=currentState();
+    std::vector<std::pair<QString,QString> > items={{"action",action},{"sid",state->sid},{"auth",state->auth}};
     items.insert(items.end(),extraItems);
     QNetworkReply* actionReply=post(this,items);
     connect(actionReply,&QNetworkReply::finished,[=]{
@@ -419,11 +441,8 @@ void ASIP::postAuthDependingAction(const QString& action,const std::initializer_
         emit error(exception);
       }
     });};
-  QReadLocker readLocker(&mostRecentData_mutex);
-  if (mostRecentData.contains("auth")) {
-    readLocker.unlock();
+  if (gameStateAvailable())
     doAction();
-  }
   else {
     const QObject* const oneTime=new QObject(this);
     connect(this,&ASIP::updated,oneTime,[=]{
@@ -442,15 +461,18 @@ std::pair<QString,QString> ASIP::dataPair(const QString& key) const
 
 QNetworkReply* ASIP::post(QObject* const requester,const std::vector<std::pair<QString,QString> >& items)
 {
-  QWriteLocker writeLocker(&mostRecentData_mutex);
   for (const auto& item:items)
-    mostRecentData.insert(item.first,item.second);
-  writeLocker.unlock();
-  const auto rawData=getRequestData(items);
-  const auto networkReply=networkAccessManager.post(server,rawData);
+    if (item.first=="username") {
+      const QWriteLocker writeLocker(&mostRecentData_mutex);
+      mostRecentData.insert(item.first,item.second);
+    }
+  const auto sessionLog=SessionLog::current();
+  const auto networkReply=(sessionLog!=nullptr && sessionLog->replaying() ? sessionLog->post(serverURL(),items) : networkAccessManager.post(server,getRequestData(items)));
   networkReply->setProperty("post_time",QDateTime::currentDateTimeUtc());
   for (const auto& item:items)
     networkReply->setProperty(qPrintable(item.first),item.second);
+  if (sessionLog!=nullptr)
+    sessionLog->logRequest(*this,*networkReply,items);
   if (requester!=nullptr)
     networkReply->setParent(requester);
   return networkReply;
@@ -461,6 +483,15 @@ void ASIP::synchronizeData(const ASIP& source)
   QWriteLocker writeLocker(&mostRecentData_mutex);
   QReadLocker readLocker(&source.mostRecentData_mutex);
   mostRecentData=source.mostRecentData;
+  moves=source.moves;
+  chat=source.chat;
+  entryStart=source.entryStart;
+  publishState();
+}
+
+void ASIP::publishState()
+{
+  std::atomic_store(&sessionState,decodeState());
 }
 
 template<class Type>
@@ -472,11 +503,103 @@ Type ASIP::get(const QString& key) const
   return value.value<Type>();
 }
 
-void ASIP::updateCache(const Data& replyData)
+std::shared_ptr<const ASIP::SessionState> ASIP::decodeState() const
+{
+  const auto result=std::make_shared<SessionState>();
+  const auto text=[this](const QString& key) {
+    return mostRecentData.value(key).toString();
+  };
+  const auto side=[&text](const QString& key) {
+    const auto value=text(key);
+    return value.isEmpty() ? NO_SIDE : toSide(value[0].toLatin1());
+  };
+  result->sid=text("sid");
+  result->auth=text("auth");
+  result->tid=text("tid");
+  result->grid=text("grid");
+  result->lastChange=text("lastchange");
+  result->movesLength=text("moveslength");
+  result->chatLength=text("chatlength");
+  result->role=side("role");
+  result->turn=side("turn");
+  if (mostRecentData.contains("result"))
+    result->status=FINISHED;
+  else if (mostRecentData.contains("starttime"))
+    result->status=LIVE;
+  else if (mostRecentData.value("canstart")==1)
+    result->status=UNSTARTED;
+  else
+    result->status=OPEN;
+  const auto gameResult=text("result").toStdString();
+  if (gameResult.size()>=2)
+    result->result={toSide(gameResult[0]),toEndCondition(gameResult[1])};
+  else
+    result->result={NO_SIDE,NO_END};
+  result->plyCount=mostRecentData.value("plycount",-1).toInt();
+  result->moveTime=mostRecentData.value("tcmove").toLongLong();
+  result->originalMoveTime=(mostRecentData.contains("tcmoveorig") ? mostRecentData.value("tcmoveorig").toLongLong() : -1);
+  result->maxTurnTime=mostRecentData.value("tcturntime").toLongLong()*1000;
+  if (result->maxTurnTime==0)
+    result->maxTurnTime=std::numeric_limits<qint64>::max();
+  for (Side side=FIRST_SIDE;side<NUM_SIDES;increment(side)) {
+    const auto sideLetter=toLetter(side);
+    const auto reserveString=QString("tc")+sideLetter+"reserve";
+    result->reserves[side]=mostRecentData.value(mostRecentData.contains(reserveString+'2') ? reserveString+'2' : reserveString).toLongLong();
+    result->used[side]=mostRecentData.value(sideLetter+QString("used")).toLongLong();
+  }
+  result->players={{text("wplayer"),text("bplayer")}};
+  result->moves=moves;
+  result->chat=chat;
+  return result;
+}
+
+bool ASIP::isPublished(const QString& key)
+{
+  // Everything decodeState reads.
+  static const QSet<QString> keys={"sid","auth","tid","grid","lastchange","moveslength","chatlength","role","turn","result","starttime","canstart","plycount","wplayer","bplayer","moves","chat"};
+  return keys.contains(key) || key.startsWith("tc") || key.endsWith("used");
+}
+
+void ASIP::updateCache(const Data& replyData,const bool incremental)
+{
+  QWriteLocker writeLocker(&mostRecentData_mutex);
+  bool changed=false;
+  std::pair<QString,bool> newMoves,newChat;
+  for (auto iter=replyData.begin();iter!=replyData.end();++iter) {
+    if (isPublished(iter.key()))
+      changed=true;
+    if (iter.key()=="moves")
+      newMoves=extend(moves,iter.value().toString(),incremental);
+    else if (iter.key()=="chat")
+      newChat=extend(chat,iter.value().toString(),incremental);
+    else
+      mostRecentData.insert(iter.key(),iter.value());
+  }
+  if (changed)
+    publishState();
+  writeLocker.unlock();
+  if (!newMoves.first.isEmpty() || newMoves.second)
+    emit movesReceived(newMoves.first,newMoves.second);
+  if (!newChat.first.isEmpty() || newChat.second)
+    emit chatReceived(newChat.first,newChat.second);
+}
+
+std::pair<QString,bool> ASIP::extend(TranscriptPtr& transcript,const QString& data,const bool incremental)
 {
-  const QWriteLocker writeLocker(&mostRecentData_mutex);
-  for (auto iter=replyData.begin();iter!=replyData.end();++iter)
-    mostRecentData.insert(iter.key(),iter.value());
+  QString segment=data;
+  bool replaced=false;
+  if (!incremental) {
+    const auto text=fullText(transcript);
+    if (!data.startsWith(text)) {
+      transcript=nullptr;
+      replaced=true;
+    }
+    else
+      segment=data.mid(text.size());
+  }
+  if (!segment.isEmpty())
+    transcript=std::make_shared<const Transcript>(Transcript{transcript,segment,(transcript==nullptr ? 0 : transcript->size)+segment.size()});
+  return {segment,replaced};
 }
 
 bool ASIP::instantResponse(const QNetworkReply& networkReply)
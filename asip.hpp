@@ -37,12 +37,41 @@ public:
     FINISHED
   };
 
+  enum EntryPhase {
+    SEAT_RESERVED,
+    SEATED,
+    STATE_RECEIVED,
+    BOARD_SHOWN,
+    NUM_ENTRY_PHASES
+  };
+
+  // Appending shares all earlier segments, so snapshots never copy the text.
+  struct Transcript {
+    std::shared_ptr<const Transcript> earlier;
+    QString segment;
+    int size;
+  };
+  typedef std::shared_ptr<const Transcript> TranscriptPtr;
+
+  struct SessionState {
+    QString sid,auth,tid,grid,lastChange,movesLength,chatLength;
+    Side role,turn;
+    Status status;
+    Result result;
+    int plyCount;
+    qint64 moveTime,originalMoveTime,maxTurnTime;
+    std::array<qint64,NUM_SIDES> reserves,used;
+    std::array<QString,NUM_SIDES> players;
+    TranscriptPtr moves,chat;
+  };
+
   explicit ASIP(QNetworkAccessManager& networkAccessManager_,const QString& serverURL,QObject* const parent=nullptr,Data startingData=Data());
   virtual std::unique_ptr<ASIP> create(QNetworkAccessManager& networkAccessManager,const QString& serverURL,QObject* const parent=nullptr,Data startingData=Data()) const=0;
   virtual ~ASIP() {}
   virtual Data processReply(QNetworkReply& networkReply);
   QUrl serverURL() const;
   qint64 timeSinceLastReply() const;
+  const TimeEstimator& latency() const {return timeEstimator;}
 
   QNetworkAccessManager& networkAccessManager;
 
@@ -62,7 +91,7 @@ public:
   virtual std::unique_ptr<ASIP> getGame(QNetworkReply& networkReply);
   virtual std::unique_ptr<QWidget> siteWidget(Server&) {return nullptr;}
 protected:
-  std::unique_ptr<ASIP> getGame() const;
+  std::unique_ptr<ASIP> getGame(const QString& role) const;
 signals:
   void sendGameList(const GameListCategory,const std::vector<GameInfo>&);
   void childStatusChanged(const Status oldStatus,const Status newStatus);
@@ -70,16 +99,19 @@ private:
   QNetworkReply* gameListAction(const QString& action,const GameListCategory gameListCategory);
 public:
   // Game server
+  std::shared_ptr<const SessionState> currentState() const;
   bool isEqualGame(const ASIP& otherGame) const;
   Side role() const;
   bool gameStateAvailable() const;
   Status getStatus() const;
   Side sideToMove() const;
-  std::tuple<GameTree,size_t,bool> getMoves(NodePtr root) const;
+  static QString fullText(const TranscriptPtr& transcript);
   std::array<QString,NUM_SIDES> getAnnotatedPlayers() const;
   std::array<QString,NUM_SIDES> getPlayers() const;
   Result getResult() const;
   std::array<std::array<qint64,3>,NUM_SIDES> getTimes() const;
+  std::array<qint64,NUM_ENTRY_PHASES> getEntryTimes() const {return entryTimes;}
+  void markEntryPhase(const EntryPhase entryPhase);
   void sit();
   void forceUpdate();
   void start();
@@ -91,30 +123,44 @@ public:
   void leave();
 private:
   void update(const bool hardSynchronization);
+  void poll(const bool wait);
+  void abortPoll();
   void postAuthDependingAction(const QString& action,const std::initializer_list<std::pair<QString,QString> >& extraItems={});
 signals:
   void updated(const bool hardSynchronization);
   void statusChanged(const Status oldStatus,const Status newStatus);
+  void movesReceived(const QString& segment,const bool replaced);
+  void chatReceived(const QString& segment,const bool replaced);
 protected:
   std::pair<QString,QString> dataPair(const QString& key) const;
   QNetworkReply* post(QObject* const requester,const std::vector<std::pair<QString,QString> >& items);
   void synchronizeData(const ASIP& source);
 
   Data mostRecentData;
+  TranscriptPtr moves,chat;
   mutable QReadWriteLock mostRecentData_mutex;
 private:
   template<class Type> Type get(const QString& key) const;
-  void updateCache(const Data& replyData);
+  std::shared_ptr<const SessionState> decodeState() const;
+  void publishState();
+  static bool isPublished(const QString& key);
+  void updateCache(const Data& replyData,const bool incremental);
+  static std::pair<QString,bool> extend(TranscriptPtr& transcript,const QString& data,const bool incremental);
   virtual QByteArray getRequestData(const std::vector<std::pair<QString,QString> >& items)=0;
   virtual Data getReplyData(const QByteArray& data)=0;
   static bool instantResponse(const QNetworkReply& networkReply);
 
   const QNetworkRequest server;
   TimeEstimator timeEstimator;
-  QDateTime lastReplyTime;
+  QDateTime lastReplyTime,entryStart;
+  std::array<qint64,NUM_ENTRY_PHASES> entryTimes;
   QNetworkReply* gameStateReply;
+  bool seated;
+  std::shared_ptr<const SessionState> sessionState;
 signals:
   void error(const std::exception& exception);
+
+  friend class PollScheduler;
 };
 
 #endif // ASIP_HPP
@@ -1,7 +1,7 @@
 #include <QHeaderView>
 #include <QTextEdit>
-#include <QNetworkReply>
-#include <QXmlStreamReader>
+#include <QNetworkDiskCache>
+#include <QStandardPaths>
 #include <QUrlQuery>
 #include <QScreen>
 #include "bots.hpp"
@@ -19,6 +19,10 @@ Bots::Bots(ASIP& session_,const QUrl& url_,MainWindow& mainWindow_) :
   url(url_),
   nameColumn(-1),
   linkColumn(-1),
+  pageReply(nullptr),
+  tableStarted(false),
+  tableEnded(false),
+  rowIndex(0),
   vBoxLayout(this),
   create(tr("Create &bot game")),
   refresh(tr("&Refresh list")),
@@ -87,91 +91,194 @@ Bots::Bots(ASIP& session_,const QUrl& url_,MainWindow& mainWindow_) :
   setAttribute(Qt::WA_DeleteOnClose);
   show();
 
-  update();
+  // Only the ladder is cached, so other requests to the server never see stale pages.
+  const auto cookieJar=networkAccessManager.cookieJar();
+  ladderAccessManager.setCookieJar(cookieJar);
+  cookieJar->setParent(&networkAccessManager);
+  const auto cacheLocation=QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  if (!cacheLocation.isEmpty()) {
+    const auto networkDiskCache=new QNetworkDiskCache(&ladderAccessManager);
+    networkDiskCache->setCacheDirectory(cacheLocation+"/http");
+    ladderAccessManager.setCache(networkDiskCache);
+  }
+  load(true);
 }
 
 void Bots::update()
 {
-  const auto networkReply=networkAccessManager.get(QNetworkRequest(url));
-  networkReply->setParent(this);
+  load(false);
+}
+
+void Bots::load(const bool fromCache)
+{
+  if (pageReply!=nullptr) {
+    disconnect(pageReply,nullptr,this,nullptr);
+    pageReply->abort();
+    pageReply->deleteLater();
+  }
+  QNetworkRequest networkRequest(url);
+  if (fromCache)
+    networkRequest.setAttribute(QNetworkRequest::CacheLoadControlAttribute,QNetworkRequest::AlwaysCache);
+  else {
+    networkRequest.setAttribute(QNetworkRequest::CacheLoadControlAttribute,QNetworkRequest::PreferNetwork);
+    networkRequest.setRawHeader("Cache-Control","no-cache");
+  }
+  const auto networkReply=ladderAccessManager.get(networkRequest);
+  pageReply=networkReply;
+
+  pendingPage.clear();
+  xmlStreamReader.clear();
+  tableStarted=false;
+  tableEnded=false;
+  rowIndex=0;
+  rowsByKey.clear();
+  receivedKeys.clear();
+  tableView.setSortingEnabled(false);
+  for (int modelRow=0;modelRow<standardItemModel.rowCount();++modelRow)
+    rowsByKey.insert(standardItemModel.index(modelRow,0).data(KEY_ROLE).toString(),modelRow);
+
+  connect(networkReply,&QNetworkReply::readyRead,this,[=] {
+    // A revalidated page is the one already shown.
+    if (!fromCache && standardItemModel.rowCount()>0 && networkReply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool()) {
+      disconnect(networkReply,&QNetworkReply::readyRead,this,nullptr);
+      return;
+    }
+    parse(networkReply->readAll());
+  });
   connect(networkReply,&QNetworkReply::finished,this,[=] {
     networkReply->deleteLater();
-    parse(networkReply->readAll());
+    pageReply=nullptr;
+    if (networkReply->error()==QNetworkReply::NoError && tableEnded)
+      finishParse();
+    else if (standardItemModel.rowCount()>0)
+      tableView.setSortingEnabled(true);
+    if (fromCache)
+      load(false);
   });
 }
 
-void Bots::parse(QString page)
+void Bots::parse(const QByteArray& data)
 {
-  const auto begin=page.indexOf("<tr",0,Qt::CaseInsensitive);
-  const auto end=page.lastIndexOf("</table",-1,Qt::CaseInsensitive);
-  page="<table>"+page.mid(begin,end-begin)+"</table>";
+  if (tableEnded)
+    return;
+  pendingPage+=data;
+  if (!tableStarted) {
+    const auto begin=pendingPage.toLower().indexOf("<tr");
+    if (begin<0)
+      return;
+    pendingPage.remove(0,begin);
+    xmlStreamReader.addData(QString("<table>"));
+    tableStarted=true;
+  }
+
+  // Only complete tags are passed on, so that the fixes below never see half of one.
+  const auto end=pendingPage.toLower().indexOf("</table");
+  const auto complete=(end>=0 ? end : pendingPage.lastIndexOf('>')+1);
+  auto page=QString::fromUtf8(pendingPage.left(complete));
+  pendingPage.remove(0,complete);
   page.replace(QRegularExpression("<td align=(.*?)>"),"<td align='\\1'>");
   page.replace(QRegularExpression("(?!&[a-z]+;)&"),"&amp;");
-  QXmlStreamReader xmlStreamReader(page);
+  xmlStreamReader.addData(page);
+  if (end>=0) {
+    xmlStreamReader.addData(QString("</table>"));
+    pendingPage.clear();
+    tableEnded=true;
+  }
+  readRows();
+}
 
-  std::vector<std::vector<std::pair<QString,QString> > > rows;
-  QString fullText,linkText,link;
-  for (auto token=xmlStreamReader.readNext();token!=QXmlStreamReader::EndDocument;token=xmlStreamReader.readNext()) {
-    if (token==QXmlStreamReader::Characters) {
+void Bots::readRows()
+{
+  while (!xmlStreamReader.atEnd()) {
+    const auto token=xmlStreamReader.readNext();
+    if (token==QXmlStreamReader::Invalid) {
+      if (xmlStreamReader.error()!=QXmlStreamReader::PrematureEndOfDocumentError)
+        tableEnded=false;
+      return;
+    }
+    else if (token==QXmlStreamReader::Characters) {
       const auto text=xmlStreamReader.text();
       fullText+=text;
       linkText+=text;
     }
     else if (xmlStreamReader.name()=="tr") {
       if (token==QXmlStreamReader::StartElement)
-        rows.emplace_back();
+        row.clear();
+      else if (token==QXmlStreamReader::EndElement) {
+        receiveRow();
+        ++rowIndex;
+      }
     }
     else if (xmlStreamReader.name()=="td") {
       if (token==QXmlStreamReader::StartElement) {
         fullText.clear();
         link.clear();
-        rows.back().emplace_back();
+        row.emplace_back();
       }
       else if (token==QXmlStreamReader::EndElement)
-        rows.back().back().first=(link.isEmpty() ? fullText : linkText).trimmed();
+        row.back().first=(link.isEmpty() ? fullText : linkText).trimmed();
     }
     else if (xmlStreamReader.name()=="a") {
       if (token==QXmlStreamReader::StartElement) {
         linkText.clear();
         link=xmlStreamReader.attributes().value("href").toString();
-        rows.back().back().second=link;
+        row.back().second=link;
       }
     }
   }
+}
 
-  standardItemModel.setRowCount(static_cast<int>(rows.size()-1));
-  for (unsigned int rowIndex=0;rowIndex<rows.size();++rowIndex) {
-    const auto& row=rows[rowIndex];
-    if (rowIndex==0) {
-      standardItemModel.setColumnCount(static_cast<int>(row.size()));
-      for (unsigned int cellIndex=0;cellIndex<row.size();++cellIndex) {
-        const auto& cell=row[cellIndex];
-        standardItemModel.setHeaderData(cellIndex,Qt::Horizontal,QString(cell.first).replace('_',' '));
-        const bool hasLink=(cell.first.toLower()=="bot_link");
-        tableView.setColumnHidden(cellIndex,hasLink);
-        if (hasLink)
-          linkColumn=cellIndex;
-        if (!cell.second.isEmpty())
-          standardItemModel.setHeaderData(cellIndex,Qt::Horizontal,cell.second,Qt::UserRole);
-        if (cell.first.toLower()=="bot_name")
-          nameColumn=cellIndex;
-      }
+void Bots::receiveRow()
+{
+  if (rowIndex==0) {
+    standardItemModel.setColumnCount(static_cast<int>(row.size()));
+    for (unsigned int cellIndex=0;cellIndex<row.size();++cellIndex) {
+      const auto& cell=row[cellIndex];
+      standardItemModel.setHeaderData(cellIndex,Qt::Horizontal,QString(cell.first).replace('_',' '));
+      const bool hasLink=(cell.first.toLower()=="bot_link");
+      tableView.setColumnHidden(cellIndex,hasLink);
+      if (hasLink)
+        linkColumn=cellIndex;
+      if (!cell.second.isEmpty())
+        standardItemModel.setHeaderData(cellIndex,Qt::Horizontal,cell.second,Qt::UserRole);
+      if (cell.first.toLower()=="bot_name")
+        nameColumn=cellIndex;
     }
-    else {
-      const unsigned int dataRowIndex=rowIndex-1;
-      for (unsigned int cellIndex=0;cellIndex<row.size();++cellIndex) {
-        const auto& cell=row[cellIndex];
-        const auto& modelIndex=standardItemModel.index(dataRowIndex,cellIndex);
-        bool isNumber;
-        const QVariant number=cell.first.toDouble(&isNumber);
-        standardItemModel.setData(modelIndex,isNumber ? number : QVariant(cell.first));
-        const auto alignment=(Qt::AlignVCenter|(isNumber ? Qt::AlignRight : (cellIndex==nameColumn ? Qt::AlignLeft : Qt::AlignHCenter)));
-        standardItemModel.itemFromIndex(modelIndex)->setTextAlignment(alignment);
-        if (!cell.second.isEmpty())
-          standardItemModel.setData(modelIndex,cell.second,Qt::UserRole);
-      }
+    return;
+  }
+
+  auto key=(nameColumn<row.size() ? row[nameColumn].first : QString::number(rowIndex));
+  if (receivedKeys.contains(key))
+    key+='\t'+QString::number(rowIndex);
+  receivedKeys.insert(key);
+  auto modelRow=rowsByKey.value(key,-1);
+  if (modelRow<0) {
+    modelRow=standardItemModel.rowCount();
+    standardItemModel.insertRow(modelRow);
+    rowsByKey.insert(key,modelRow);
+  }
+  for (unsigned int cellIndex=0;cellIndex<row.size();++cellIndex) {
+    const auto& cell=row[cellIndex];
+    const auto& modelIndex=standardItemModel.index(modelRow,cellIndex);
+    bool isNumber;
+    const QVariant number=cell.first.toDouble(&isNumber);
+    const auto value=(isNumber ? number : QVariant(cell.first));
+    if (modelIndex.data()!=value) {
+      standardItemModel.setData(modelIndex,value);
+      const auto alignment=(Qt::AlignVCenter|(isNumber ? Qt::AlignRight : (cellIndex==nameColumn ? Qt::AlignLeft : Qt::AlignHCenter)));
+      standardItemModel.itemFromIndex(modelIndex)->setTextAlignment(alignment);
     }
+    if (!cell.second.isEmpty() && modelIndex.data(Qt::UserRole)!=cell.second)
+      standardItemModel.setData(modelIndex,cell.second,Qt::UserRole);
   }
+  standardItemModel.setData(standardItemModel.index(modelRow,0),key,KEY_ROLE);
+}
+
+void Bots::finishParse()
+{
+  for (int modelRow=standardItemModel.rowCount()-1;modelRow>=0;--modelRow)
+    if (!receivedKeys.contains(standardItemModel.index(modelRow,0).data(KEY_ROLE).toString()))
+      standardItemModel.removeRow(modelRow);
   tableView.horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
   tableView.horizontalHeader()->setStretchLastSection(true);
   tableView.horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
@@ -4,7 +4,10 @@
 #include <memory>
 #include <QDialog>
 #include <QUrl>
+#include <QSet>
 #include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QXmlStreamReader>
 #include <QStandardItemModel>
 #include <QLayout>
 #include <QTableView>
@@ -22,7 +25,11 @@ public:
   explicit Bots(ASIP& session_,const QUrl& url_,MainWindow& mainWindow_);
 private:
   void update();
-  void parse(QString page);
+  void load(const bool fromCache);
+  void parse(const QByteArray& data);
+  void readRows();
+  void receiveRow();
+  void finishParse();
   void createGame(const QModelIndex& index);
   void enterGame(const ASIP::GameInfo& game,const Side role,const Side viewpoint);
   void enable();
@@ -31,10 +38,22 @@ private:
 
   ASIP& session;
   QNetworkAccessManager& networkAccessManager;
+  QNetworkAccessManager ladderAccessManager;
   MainWindow& mainWindow;
   const QUrl url;
   QStandardItemModel standardItemModel;
   unsigned int nameColumn,linkColumn;
+  QNetworkReply* pageReply;
+  QByteArray pendingPage;
+  QXmlStreamReader xmlStreamReader;
+  bool tableStarted,tableEnded;
+  unsigned int rowIndex;
+  std::vector<std::pair<QString,QString> > row;
+  QString fullText,linkText,link;
+  QHash<QString,int> rowsByKey;
+  QSet<QString> receivedKeys;
+
+  static constexpr int KEY_ROLE=Qt::UserRole+1;
 
   QVBoxLayout vBoxLayout;
     QHBoxLayout hBoxLayout;
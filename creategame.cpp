@@ -51,7 +51,7 @@ CreateGame::CreateGame(Globals& globals_,ASIP& session_,Server& server_) :
       side=Side(globals.rand(NUM_SIDES));
     }
     const auto networkReply=session.createGame(this,timeControl.toString(timed.isChecked()),timed.isChecked() && rated.isChecked(),side);
-    connect(networkReply,&QNetworkReply::finished,this,[=]{creationAttempt(*networkReply);});
+    connect(networkReply,&QNetworkReply::finished,this,[=]{creationAttempt(*networkReply,side);});
   });
   connect(&dialogButtonBox,&QDialogButtonBox::rejected,this,&CreateGame::close);
   vBoxLayout.addWidget(&dialogButtonBox);
@@ -59,10 +59,10 @@ CreateGame::CreateGame(Globals& globals_,ASIP& session_,Server& server_) :
   timeControl.moveTime.seconds.setFocus();
 }
 
-void CreateGame::creationAttempt(QNetworkReply& networkReply)
+void CreateGame::creationAttempt(QNetworkReply& networkReply,const Side side)
 {
   try {
-    server.addGame(networkReply,session.role(),true);
+    server.addGame(networkReply,side,true);
     server.refreshPage();
     close();
     timeControl.writeSettings(globals.settings);
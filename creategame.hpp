@@ -17,7 +17,7 @@ class CreateGame : public QDialog {
   Q_OBJECT
 public:
   explicit CreateGame(Globals& globals_,ASIP& session_,Server& server_);
-  void creationAttempt(QNetworkReply& networkReply);
+  void creationAttempt(QNetworkReply& networkReply,const Side side);
 private:
   Globals& globals;
   const Server& server;
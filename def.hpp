@@ -366,16 +366,18 @@ inline void forEachAdjacentSquare(const SquareIndex square,Function function)
     return;
 }
 
-inline Squares adjacentSquares(const SquareIndex square)
-{
-  if (square==NO_SQUARE)
-    return Squares();
-  Squares result;
-  forEachAdjacentSquare(square,[&result](const SquareIndex adjacentSquare) {
-    result.emplace_back(adjacentSquare);
-    return false;
-  });
-  return result;
+inline const Squares& adjacentSquares(const SquareIndex square)
+{
+  static const auto table=[] {
+    std::array<Squares,NUM_SQUARES+1> result;
+    for (SquareIndex square=FIRST_SQUARE;square<NUM_SQUARES;increment(square))
+      forEachAdjacentSquare(square,[&](const SquareIndex adjacentSquare) {
+        result[square].emplace_back(adjacentSquare);
+        return false;
+      });
+    return result;
+  }();
+  return table[square==NO_SQUARE ? NUM_SQUARES : square];
 }
 
 inline SquareIndex adjacentTrap(const SquareIndex trapNeighbor)
@@ -0,0 +1,214 @@
+#include <QCoreApplication>
+#include <QSettings>
+#include "engine.hpp"
+#include "io.hpp"
+
+std::multimap<Engine::Configuration,Engine*> Engine::idleEngines;
+
+Engine::Engine(const Configuration& configuration_) :
+  QObject(QCoreApplication::instance()),
+  configuration(configuration_),
+  process(this),
+  idleTimer(this),
+  handshakeDone(false),
+  customized(false),
+  searching_(false),
+  pendingStops(0)
+{
+  idleTimer.setSingleShot(true);
+  idleTimer.setInterval(10*60*1000);
+  connect(&idleTimer,&QTimer::timeout,this,&Engine::deleteLater);
+
+  connect(&process,&QProcess::readyReadStandardOutput,this,&Engine::processStandardOutput);
+  connect(&process,&QProcess::errorOccurred,this,[this](const QProcess::ProcessError error) {
+    searching_=false;
+    switch (error) {
+      case QProcess::FailedToStart: emit failed(tr("Failed to start.")); break;
+      case QProcess::Crashed:       emit failed(tr("Crashed.")); break;
+      case QProcess::Timedout:      emit failed(tr("Timed out.")); break;
+      case QProcess::ReadError:     emit failed(tr("Read error.")); break;
+      case QProcess::WriteError:    emit failed(tr("Write error.")); break;
+      case QProcess::UnknownError:  emit failed(tr("Unknown error.")); break;
+    };
+  });
+  connect(&process,static_cast<void (QProcess::*)(int,QProcess::ExitStatus)>(&QProcess::finished),this,[this] {
+    if (searching_) {
+      searching_=false;
+      emit failed(tr("Engine quit while searching."));
+    }
+    if (idleTimer.isActive())
+      deleteLater();
+  });
+  process.start(configuration.executable,configuration.arguments);
+  process.write("aei\n");
+  QTimer::singleShot(10*1000,this,[this] {
+    if (!handshakeDone && process.state()!=QProcess::NotRunning)
+      emit failed(tr("No AEI handshake."));
+  });
+}
+
+Engine::~Engine()
+{
+  for (auto idleEngine=idleEngines.begin();idleEngine!=idleEngines.end();++idleEngine)
+    if (idleEngine->second==this) {
+      idleEngines.erase(idleEngine);
+      break;
+    }
+  disconnect(&process,nullptr,this,nullptr);
+  if (process.state()==QProcess::Running) {
+    process.write("quit\n");
+    if (!process.waitForFinished(1000))
+      process.kill();
+  }
+}
+
+Engine::Configuration Engine::savedConfiguration(QSettings& settings)
+{
+  Configuration configuration;
+  settings.beginGroup("Analysis");
+  configuration.executable=settings.value("executable").toString();
+  for (const auto key:{"first_arguments","middle_arguments","last_arguments"})
+    configuration.arguments.append(settings.value(key).toString().split('\n',Qt::SkipEmptyParts));
+  settings.endGroup();
+  return configuration;
+}
+
+std::shared_ptr<Engine> Engine::acquire(const Configuration& configuration)
+{
+  Engine* engine;
+  const auto idleEngine=idleEngines.find(configuration);
+  if (idleEngine==idleEngines.end())
+    engine=new Engine(configuration);
+  else {
+    engine=idleEngine->second;
+    idleEngines.erase(idleEngine);
+    engine->idleTimer.stop();
+  }
+  return std::shared_ptr<Engine>(engine,&Engine::release);
+}
+
+void Engine::release(Engine* const engine)
+{
+  disconnect(engine,nullptr,nullptr,nullptr);
+  if (engine->process.state()==QProcess::NotRunning || engine->customized)
+    engine->deleteLater();
+  else {
+    engine->stop();
+    idleEngines.emplace(engine->configuration,engine);
+    engine->idleTimer.start();
+  }
+}
+
+void Engine::analyze(const NodePtr& node)
+{
+  stop();
+  for (const auto& command:positionCommands(node))
+    write(command);
+  write("go");
+  searching_=true;
+}
+
+void Engine::setOption(const QString& name,const QString& value)
+{
+  write("setoption name "+name+" value "+value);
+  customized=true;
+}
+
+void Engine::stop(const bool discard)
+{
+  if (searching_) {
+    write("stop");
+    if (discard) {
+      ++pendingStops;
+      searching_=false;
+    }
+  }
+}
+
+bool Engine::searching() const
+{
+  return searching_;
+}
+
+std::vector<QString> Engine::positionCommands(const NodePtr& node)
+{
+  std::vector<QString> result{"newgame"};
+  const auto ancestors=Node::selfAndAncestors(node);
+  auto ancestor=ancestors.rbegin();
+  const auto root=ancestor->lock();
+  if (!root->isGameStart()) {
+    std::string board;
+    for (int rank=NUM_RANKS-1;rank>=0;--rank)
+      for (int file=0;file<NUM_FILES;++file) {
+        const auto piece=root->gameState.squarePieces[toSquare(file,rank)];
+        board+=(piece==NO_PIECE ? ' ' : pieceLetters[piece]);
+      }
+    result.emplace_back(QString("setposition %1 [%2]").arg(toLetter(root->gameState.sideToMove,true)).arg(QString::fromStdString(board)));
+  }
+  for (++ancestor;ancestor!=ancestors.rend();++ancestor)
+    result.emplace_back("makemove "+QString::fromStdString(ancestor->lock()->toString()));
+  return result;
+}
+
+NodePtr Engine::applyMove(const NodePtr& node,const QString& move)
+{
+  Placements setup;
+  ExtendedSteps steps;
+  try {
+    if (std::get<1>(toTree(move.toStdString(),node,setup,steps))!=0)
+      return nullptr;
+  }
+  catch (const std::exception&) {
+    return nullptr;
+  }
+  if (node->inSetup())
+    return setup.size()==numStartingPieces ? Node::addSetup(node,setup,true) : nullptr;
+  else if (!steps.empty() && node->legalMove(steps)==MoveLegality::LEGAL)
+    return Node::makeMove(node,steps,true);
+  else
+    return nullptr;
+}
+
+void Engine::write(const QString& command)
+{
+  if (handshakeDone)
+    process.write(command.toUtf8()+'\n');
+  else
+    pendingCommands.append(command);
+}
+
+void Engine::processStandardOutput()
+{
+  buffer+=process.readAllStandardOutput();
+  for (int lineEnd;(lineEnd=buffer.indexOf('\n'))>=0;) {
+    const auto line=QString::fromUtf8(buffer.left(lineEnd)).trimmed();
+    buffer.remove(0,lineEnd+1);
+    processLine(line);
+  }
+}
+
+void Engine::processLine(const QString& line)
+{
+  if (!handshakeDone) {
+    if (line=="aeiok") {
+      handshakeDone=true;
+      for (const auto& command:pendingCommands)
+        write(command);
+      pendingCommands.clear();
+    }
+  }
+  else if (line.startsWith("bestmove")) {
+    if (pendingStops>0)
+      --pendingStops;
+    else {
+      searching_=false;
+      emit receivedLine(line);
+      emit receivedBestMove(line.mid(int(strlen("bestmove"))).trimmed());
+    }
+  }
+  else if (pendingStops==0 && !line.isEmpty()) {
+    emit receivedLine(line);
+    if (line.startsWith("info "))
+      emit receivedInfo(line.section(' ',1,1),line.section(' ',2));
+  }
+}
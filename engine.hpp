@@ -0,0 +1,53 @@
+#ifndef ENGINE_HPP
+#define ENGINE_HPP
+
+#include <map>
+class QSettings;
+#include <QProcess>
+#include <QTimer>
+#include "node.hpp"
+
+class Engine : public QObject {
+  Q_OBJECT
+public:
+  struct Configuration {
+    QString executable;
+    QStringList arguments;
+    bool operator<(const Configuration& rhs) const {return std::tie(executable,arguments)<std::tie(rhs.executable,rhs.arguments);}
+  };
+
+  static Configuration savedConfiguration(QSettings& settings);
+  static std::shared_ptr<Engine> acquire(const Configuration& configuration);
+  ~Engine();
+  void analyze(const NodePtr& node);
+  void setOption(const QString& name,const QString& value);
+  void stop(const bool discard=true);
+  bool searching() const;
+  static std::vector<QString> positionCommands(const NodePtr& node);
+  static NodePtr applyMove(const NodePtr& node,const QString& move);
+private:
+  explicit Engine(const Configuration& configuration_);
+  static void release(Engine* const engine);
+  void write(const QString& command);
+  void processStandardOutput();
+  void processLine(const QString& line);
+
+  const Configuration configuration;
+  QProcess process;
+  QTimer idleTimer;
+  QByteArray buffer;
+  QStringList pendingCommands;
+  bool handshakeDone;
+  bool customized;
+  bool searching_;
+  unsigned int pendingStops;
+
+  static std::multimap<Configuration,Engine*> idleEngines;
+signals:
+  void receivedLine(const QString& line);
+  void receivedBestMove(const QString& move);
+  void receivedInfo(const QString& type,const QString& value);
+  void failed(const QString& message);
+};
+
+#endif // ENGINE_HPP
@@ -0,0 +1,93 @@
+#include "enginepool.hpp"
+
+using namespace std;
+EnginePool::EnginePool(const Engine::Configuration& configuration,const unsigned int numEngines,const int secondsPerPosition,QObject* const parent) :
+  QObject(parent),
+  numBusy(0)
+{
+  for (unsigned int engineIndex=0;engineIndex<numEngines;++engineIndex) {
+    workers.emplace_back(make_unique<Worker>());
+    auto& worker=*workers.back().get();
+    worker.engine=Engine::acquire(configuration);
+    worker.engine->setOption("tcmove",QString::number(secondsPerPosition));
+    worker.timer.setSingleShot(true);
+    worker.timer.setInterval((secondsPerPosition+5)*1000);
+    connect(&worker.timer,&QTimer::timeout,this,[&worker] {
+      if (worker.engine!=nullptr)
+        worker.engine->stop(false);
+    });
+    connect(worker.engine.get(),&Engine::receivedInfo,this,[&worker](const QString& type,const QString& value) {
+      if (type=="score")
+        worker.score=value.toStdString();
+    });
+    connect(worker.engine.get(),&Engine::receivedBestMove,this,[this,&worker](const QString& move) {
+      receiveBestMove(worker,move);
+    });
+    connect(worker.engine.get(),&Engine::failed,this,[this,&worker](const QString& message) {
+      receiveFailure(worker,message);
+    });
+  }
+}
+
+void EnginePool::analyze(const std::vector<NodePtr>& nodes)
+{
+  queue.insert(queue.end(),nodes.begin(),nodes.end());
+  for (const auto& worker:workers)
+    if (worker->engine!=nullptr && worker->node==nullptr)
+      dispatch(*worker.get());
+}
+
+size_t EnginePool::remaining() const
+{
+  return queue.size()+numBusy;
+}
+
+void EnginePool::dispatch(Worker& worker)
+{
+  if (queue.empty()) {
+    worker.node=nullptr;
+    if (numBusy==0)
+      emit finished();
+  }
+  else {
+    worker.node=queue.front();
+    queue.pop_front();
+    worker.score.clear();
+    worker.engine->analyze(worker.node);
+    worker.timer.start();
+    ++numBusy;
+  }
+}
+
+void EnginePool::receiveBestMove(Worker& worker,const QString& move)
+{
+  if (worker.node==nullptr)
+    return;
+  worker.timer.stop();
+  --numBusy;
+  const auto node=worker.node;
+  node->score=worker.score;
+  node->bestMove=move.toStdString();
+  emit analyzed(node);
+  dispatch(worker);
+}
+
+void EnginePool::receiveFailure(Worker& worker,const QString& message)
+{
+  worker.timer.stop();
+  if (worker.node!=nullptr) {
+    --numBusy;
+    queue.push_front(worker.node);
+    worker.node=nullptr;
+  }
+  worker.engine.reset();
+  bool anyEngine=false;
+  for (const auto& other:workers)
+    if (other->engine!=nullptr) {
+      anyEngine=true;
+      if (other->node==nullptr && !queue.empty())
+        dispatch(*other.get());
+    }
+  if (!anyEngine)
+    emit failed(message);
+}
@@ -0,0 +1,33 @@
+#ifndef ENGINEPOOL_HPP
+#define ENGINEPOOL_HPP
+
+#include <deque>
+#include "engine.hpp"
+
+class EnginePool : public QObject {
+  Q_OBJECT
+public:
+  EnginePool(const Engine::Configuration& configuration,const unsigned int numEngines,const int secondsPerPosition,QObject* const parent=nullptr);
+  void analyze(const std::vector<NodePtr>& nodes);
+  size_t remaining() const;
+private:
+  struct Worker {
+    std::shared_ptr<Engine> engine;
+    NodePtr node;
+    std::string score;
+    QTimer timer;
+  };
+  void dispatch(Worker& worker);
+  void receiveBestMove(Worker& worker,const QString& move);
+  void receiveFailure(Worker& worker,const QString& message);
+
+  std::vector<std::unique_ptr<Worker> > workers;
+  std::deque<NodePtr> queue;
+  size_t numBusy;
+signals:
+  void analyzed(const NodePtr& node);
+  void finished();
+  void failed(const QString& message);
+};
+
+#endif // ENGINEPOOL_HPP
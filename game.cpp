@@ -6,13 +6,16 @@
 #include <QHeaderView>
 #include <QClipboard>
 #include <QMouseEvent>
+#include <QThread>
 #include "game.hpp"
 #include "globals.hpp"
 #include "mainwindow.hpp"
 #include "asip.hpp"
+#include "pollscheduler.hpp"
 #include "messagebox.hpp"
 #include "offboard.hpp"
 #include "startanalysis.hpp"
+#include "analysis.hpp"
 #include "io.hpp"
 
 using namespace std;
@@ -28,10 +31,14 @@ Game::Game(Globals& globals_,const Side viewpoint,QWidget* const parent,const st
   dockWidgetResized(false),
   galleries{{{board,FIRST_SIDE},{board,SECOND_SIDE}}},
   processedMoves(0),
+  parsedNode(treeModel.root),
+  parsedNodeChanges(0),
   nextTickTime(-1),
   finished(false),
   moveSynchronization(true),
   forceUpdate("Force server &update"),
+  premove(tr("&Premove")),
+  clearPremoves(tr("C&lear premoves")),
   resign(tr("&Resign")),
   fullScreen(tr("&Full screen")),
   rotate(tr("&Rotate")),
@@ -113,6 +120,19 @@ void Game::addGameMenu(const bool controllable)
     connect(&forceUpdate,&QAction::triggered,session.get(),&ASIP::forceUpdate);
   gameMenu->addAction(&forceUpdate);
 
+  premove.setEnabled(session!=nullptr && controllable);
+  premove.setShortcut(QKeySequence(Qt::CTRL+Qt::Key_P));
+  connect(&premove,&QAction::triggered,this,&Game::addPremove);
+  gameMenu->addAction(&premove);
+
+  clearPremoves.setEnabled(false);
+  connect(&clearPremoves,&QAction::triggered,this,[this] {
+    premoves.clear();
+    clearPremoves.setEnabled(false);
+    updateCornerMessage();
+  });
+  gameMenu->addAction(&clearPremoves);
+
   resign.setEnabled(session!=nullptr && controllable);
   resign.setShortcut(QKeySequence(Qt::CTRL+Qt::Key_R));
   connect(&resign,&QAction::triggered,[=]{
@@ -445,8 +465,26 @@ void Game::initLiveGame()
     setPlayerBars(board.southIsUp);
     connect(&board,&Board::boardRotated,this,&Game::setPlayerBars);
 
+    const auto state=session->currentState();
+    receiveMoves(ASIP::fullText(state->moves),true);
+    connect(session.get(),&ASIP::movesReceived,this,&Game::receiveMoves);
+
+    chatDock.setObjectName("Chat");
+    chatDock.setWindowTitle(tr("Chat"));
+    chatDock.setAllowedAreas(Qt::LeftDockWidgetArea|Qt::RightDockWidgetArea);
+    chatDock.setFeatures(QDockWidget::DockWidgetClosable|QDockWidget::DockWidgetMovable|QDockWidget::DockWidgetFloatable);
+    chatView.setReadOnly(true);
+    chatDock.setWidget(&chatView);
+    addDockWidget(Qt::RightDockWidgetArea,chatDock,Qt::Vertical,false);
+    receiveChat(ASIP::fullText(state->chat),true);
+    connect(session.get(),&ASIP::chatReceived,this,&Game::receiveChat);
+
     if (session->gameStateAvailable())
       synchronize(false);
+    else {
+      setWindowTitle(tr("Joining game %1").arg(session->currentState()->tid));
+      cornerMessage.setText(tr("Joining game..."));
+    }
     connect(session.get(),&ASIP::updated,this,&Game::synchronize);
     connect(session.get(),&ASIP::statusChanged,this,[this](const ASIP::Status oldStatus,const ASIP::Status newStatus) {
       QApplication::alert(this);
@@ -529,9 +567,107 @@ void Game::contextMenu()
     connect(analysis,&QAction::triggered,this,[this]{openDialog(new StartAnalysis(globals,board.currentNode.get(),board.tentativeMove(),this));});
   menu->addAction(analysis);
 
+  const auto builtInAnalysis=new QAction(tr("Run built-in analysis"),menu);
+  if (disabled || board.currentNode->inSetup() || board.currentNode->result.endCondition!=NO_END)
+    builtInAnalysis->setEnabled(false);
+  else
+    connect(builtInAnalysis,&QAction::triggered,this,[this] {
+      globals.settings.beginGroup("Analysis");
+      const auto seconds=globals.settings.value("built_in_seconds",10).toInt();
+      globals.settings.endGroup();
+      const auto node=Node::reroot(board.currentNode.get());
+      const auto analysis=new Analysis(globals,node,make_unique<AlphaBeta>(node),seconds*1000,this);
+      connect(analysis,&Analysis::sendPosition,this,&Game::setPosition);
+      analysis->show();
+    });
+  menu->addAction(builtInAnalysis);
+
+  for (const bool wholeTree:{false,true}) {
+    const auto analyzeGame=new QAction(wholeTree ? tr("Analyze all positions") : tr("Analyze main line"),menu);
+    if (disabled)
+      analyzeGame->setEnabled(false);
+    else
+      connect(analyzeGame,&QAction::triggered,this,[this,wholeTree]{this->analyzeGame(wholeTree);});
+    menu->addAction(analyzeGame);
+  }
+
+  const auto annotateThreats=new QAction(tr("Annotate threats"),menu);
+  if (disabled || threatAnnotator!=nullptr)
+    annotateThreats->setEnabled(false);
+  else
+    connect(annotateThreats,&QAction::triggered,this,&Game::annotateThreats);
+  menu->addAction(annotateThreats);
+
   menu->popup(QCursor::pos());
 }
 
+void Game::analyzeGame(const bool wholeTree)
+{
+  const auto configuration=Engine::savedConfiguration(globals.settings);
+  globals.settings.beginGroup("Analysis");
+  const auto defaultSeconds=globals.settings.value("seconds_per_position",10).toInt();
+  globals.settings.endGroup();
+  if (configuration.executable.isEmpty()) {
+    MessageBox(QMessageBox::Critical,tr("Error analyzing"),tr("No analysis executable has been set."),QMessageBox::NoButton,this).exec();
+    return;
+  }
+
+  bool ok;
+  const auto seconds=QInputDialog::getInt(this,tr("Analyze game"),tr("Seconds per position:"),defaultSeconds,1,24*60*60,1,&ok);
+  if (!ok)
+    return;
+  globals.settings.beginGroup("Analysis");
+  globals.settings.setValue("seconds_per_position",seconds);
+  globals.settings.endGroup();
+
+  std::vector<NodePtr> nodes;
+  if (wholeTree) {
+    std::vector<NodePtr> stack{treeModel.root};
+    while (!stack.empty()) {
+      const auto node=stack.back();
+      stack.pop_back();
+      nodes.emplace_back(node);
+      for (int childIndex=node->numChildren()-1;childIndex>=0;--childIndex)
+        if (const auto child=node->child(childIndex))
+          stack.emplace_back(child);
+    }
+  }
+  else {
+    for (const auto& node:Node::selfAndAncestors(gameTree.front()))
+      nodes.emplace_back(node.lock());
+    reverse(nodes.begin(),nodes.end());
+  }
+  nodes.erase(remove_if(nodes.begin(),nodes.end(),[](const NodePtr& node) {
+    return node==nullptr || node->inSetup() || node->result.endCondition!=NO_END;
+  }),nodes.end());
+  if (nodes.empty())
+    return;
+
+  enginePool=make_unique<EnginePool>(configuration,std::min<size_t>(QThread::idealThreadCount(),nodes.size()),seconds);
+  connect(enginePool.get(),&EnginePool::analyzed,this,[this](const NodePtr& node) {
+    emit treeModel.dataChanged(treeModel.index(node,0),treeModel.lastIndex(node),{Qt::ToolTipRole});
+  });
+  connect(enginePool.get(),&EnginePool::finished,this,[this] {
+    QApplication::alert(this);
+  });
+  connect(enginePool.get(),&EnginePool::failed,this,[this](const QString& message) {
+    MessageBox(QMessageBox::Critical,tr("Error analyzing"),message,QMessageBox::NoButton,this).exec();
+  });
+  enginePool->analyze(nodes);
+}
+
+void Game::annotateThreats()
+{
+  threatAnnotator=make_unique<ThreatAnnotator>();
+  connect(threatAnnotator.get(),&ThreatAnnotator::annotated,this,[this](const NodePtr& node) {
+    emit treeModel.dataChanged(treeModel.index(node,0),treeModel.lastIndex(node),{Qt::DisplayRole,Qt::ToolTipRole});
+  });
+  connect(&treeModel,&QAbstractItemModel::layoutChanged,threatAnnotator.get(),[this] {
+    threatAnnotator->annotate(treeModel.root);
+  });
+  threatAnnotator->annotate(treeModel.root);
+}
+
 void Game::mousePressEvent(QMouseEvent* event)
 {
   switch (event->button()) {
@@ -565,6 +701,11 @@ bool Game::event(QEvent* event)
       if (QCoreApplication::sendEvent(&board,event))
         return true;
     break;
+    case QEvent::Show:
+    case QEvent::Hide:
+      if (session!=nullptr)
+        PollScheduler::of(*session).setShown(*session,event->type()==QEvent::Show);
+    break;
     default: break;
   }
   return QMainWindow::event(event);
@@ -642,6 +783,40 @@ void Game::flipGalleries()
   }
 }
 
+void Game::receiveMoves(const QString& segment,const bool replaced)
+{
+  if (replaced) {
+    parsedNode=treeModel.root;
+    parsedSetup.clear();
+    parsedMove.clear();
+    parsedNodeChanges=0;
+    unparsedMoves.clear();
+  }
+  unparsedMoves+=segment.toStdString();
+  // Only parse up to the last whitespace, as the final word may still be cut off.
+  const auto end=unparsedMoves.find_last_of(" \t\r\n");
+  if (end==std::string::npos)
+    return;
+  auto setup=parsedSetup;
+  auto move=parsedMove;
+  const auto result=toTree(unparsedMoves.substr(0,end+1),parsedNode,setup,move);
+  parsedNode=get<0>(result).front();
+  parsedSetup=setup;
+  parsedMove=move;
+  parsedNodeChanges+=get<1>(result);
+  unparsedMoves.erase(0,end+1);
+}
+
+void Game::receiveChat(const QString& segment,const bool replaced)
+{
+  if (replaced)
+    chatView.setPlainText(segment);
+  else {
+    chatView.moveCursor(QTextCursor::End);
+    chatView.insertPlainText(segment);
+  }
+}
+
 void Game::synchronize(const bool hard)
 {
   const auto status=session->getStatus();
@@ -665,7 +840,8 @@ void Game::synchronize(const bool hard)
     playerBars[side].player.setText(players[side]);
     playerBars[side].setActive(side==sideToMove);
   }
-  const auto moves=session->getMoves(treeModel.root);
+  auto moves=toCompletedTree(unparsedMoves,parsedNode,parsedSetup,parsedMove);
+  get<1>(moves)+=parsedNodeChanges;
   auto result=session->getResult();
   if (processMoves(moves,role,result,hard))
     nextTickTime=-1;
@@ -686,8 +862,12 @@ void Game::synchronize(const bool hard)
   if (!finished && result.endCondition!=NO_END) {
     finished=true;
     resign.setEnabled(false);
+    premoves.clear();
+    premove.setEnabled(false);
+    clearPremoves.setEnabled(false);
     announceResult(result);
   }
+  session->markEntryPhase(ASIP::BOARD_SHOWN);
 }
 
 void Game::updateTimes()
@@ -714,7 +894,10 @@ qint64 Game::updateCornerMessage()
   auto nextChange=std::numeric_limits<qint64>::max();
   if (session!=nullptr && session->getStatus()!=ASIP::FINISHED) {
     const auto timeSinceLastReply=session->timeSinceLastReply();
-    cornerMessage.setText(tr("Last server response: ")+PlayerBar::timeDisplay(timeSinceLastReply));
+    auto text=tr("Last server response: ")+PlayerBar::timeDisplay(timeSinceLastReply);
+    if (!premoves.empty())
+      text+=tr(" | Premoves: %1").arg(premoves.size());
+    cornerMessage.setText(text);
     nextChange=1000-timeSinceLastReply%1000;
   }
   else
@@ -766,6 +949,53 @@ void Game::setExploration(const bool on)
   emit treeModel.layoutChanged();
 }
 
+void Game::addPremove()
+{
+  const auto node=board.currentNode.get();
+  const auto role=session->role();
+  if (finished || node==nullptr || node->previousNode==nullptr || node->previousNode->previousNode!=liveNode || liveNode->gameState.sideToMove!=otherSide(role)) {
+    MessageBox(QMessageBox::Critical,tr("Invalid premove"),tr("Explore an opponent's move from the live position followed by your reply."),QMessageBox::NoButton,this).exec();
+    return;
+  }
+  const auto expectedMove=node->previousNode;
+  premoves.erase(remove_if(premoves.begin(),premoves.end(),[&expectedMove](const NodePtr& reply){return reply->previousNode==expectedMove;}),premoves.end());
+  premoves.emplace_back(node);
+  clearPremoves.setEnabled(true);
+  updateCornerMessage();
+}
+
+void Game::sendPremove(const Side role)
+{
+  if (premoves.empty())
+    return;
+  NodePtr reply;
+  for (const auto& premove:premoves)
+    if (premove->previousNode==liveNode)
+      reply=premove;
+  // A synchronization that only rewinds the live node leaves the premoves further ahead reachable.
+  premoves.erase(remove_if(premoves.begin(),premoves.end(),[this,&reply](const NodePtr& premove) {
+    return premove==reply || !liveNode->isAncestorOfOrSameAs(premove->previousNode.get());
+  }),premoves.end());
+  clearPremoves.setEnabled(!premoves.empty());
+  if (reply==nullptr || liveNode->gameState.sideToMove!=role || liveNode->result.endCondition!=NO_END)
+    return;
+  if (!liveNode->inSetup() && liveNode->legalMove(reply->move)!=MoveLegality::LEGAL)
+    return;
+
+  liveNode=reply;
+  premoves.clear();
+  clearPremoves.setEnabled(false);
+  session->sendMove(QString::fromStdString(reply->toString()));
+  ++processedMoves;
+  nextTickTime=-1;
+  if (board.explore)
+    expandToNode(*liveNode);
+  else {
+    board.setNode(liveNode,false,true);
+    processVisibleNode(liveNode);
+  }
+}
+
 void Game::processInput(const std::string& input)
 {
   try {
@@ -818,6 +1048,8 @@ bool Game::processMoves(const std::tuple<GameTree,size_t,bool>& moves,const Side
   else
     receiveGameTree(receivedTree,role==otherSide(serverNode.gameState.sideToMove));
   processedMoves=sessionMoves;
+  if (result.endCondition==NO_END)
+    sendPremove(role);
   return true;
 }
 
@@ -5,6 +5,7 @@
 #include <QMainWindow>
 #include <QDockWidget>
 #include <QTreeView>
+#include <QPlainTextEdit>
 #include <QTimer>
 #include <QAction>
 #include <QCheckBox>
@@ -14,6 +15,8 @@ class ASIP;
 #include "board.hpp"
 #include "playerbar.hpp"
 #include "offboard.hpp"
+#include "enginepool.hpp"
+#include "threatannotator.hpp"
 
 class Game : public QMainWindow {
   Q_OBJECT
@@ -31,6 +34,8 @@ protected:
   void initLiveGame();
   void saveDockStates();
   void contextMenu();
+  void analyzeGame(const bool wholeTree);
+  void annotateThreats();
   virtual void mousePressEvent(QMouseEvent* event) override;
   virtual bool event(QEvent* event) override;
   virtual bool eventFilter(QObject* watched,QEvent* event) override;
@@ -38,11 +43,15 @@ protected:
   static std::vector<qint64> getTickTimes();
   void setPlayerBars(const bool southIsUp);
   void flipGalleries();
+  void receiveMoves(const QString& segment,const bool replaced);
+  void receiveChat(const QString& segment,const bool replaced);
   void synchronize(const bool hard);
   void updateTimes();
   qint64 updateCornerMessage();
   void soundTicker(const Side sideToMove,const qint64 timeLeft);
   void setExploration(const bool on);
+  void addPremove();
+  void sendPremove(const Side role);
   void processInput(const std::string& input);
   bool processMoves(const std::tuple<GameTree,size_t,bool>& moves,const Side role,const Result& result,const bool hardSynchronization);
   void receiveGameTree(const GameTree& gameTreeNode,const bool silent);
@@ -69,13 +78,23 @@ protected:
   PlayerBar playerBars[NUM_SIDES];
   std::array<OffBoard,NUM_SIDES> galleries;
   QTreeView treeView;
+  QDockWidget chatDock;
+  QPlainTextEdit chatView;
   QTimer timer,ticker;
   size_t processedMoves;
+  NodePtr parsedNode;
+  Placements parsedSetup;
+  ExtendedSteps parsedMove;
+  size_t parsedNodeChanges;
+  std::string unparsedMoves;
   int nextTickTime;
   bool finished;
   bool moveSynchronization;
+  std::unique_ptr<EnginePool> enginePool;
+  std::unique_ptr<ThreatAnnotator> threatAnnotator;
+  std::vector<NodePtr> premoves;
 
-  QAction forceUpdate,resign,fullScreen,rotate,autoRotate,animate,animationDelay,sound,volume,stepMode,confirm,moveList;
+  QAction forceUpdate,premove,clearPremoves,resign,fullScreen,rotate,autoRotate,animate,animationDelay,sound,volume,stepMode,confirm,moveList;
   std::unique_ptr<QAction> offBoards[NUM_SIDES];
   QWidget cornerWidget;
   QHBoxLayout cornerLayout;
@@ -1,36 +1,39 @@
+#include <algorithm>
+#include <QCoreApplication>
 #include <QHeaderView>
 #include <QNetworkReply>
 #include <QMenu>
+#include <QSet>
 #include "gamelist.hpp"
 #include "server.hpp"
 #include "io.hpp"
 #include "messagebox.hpp"
 
 GameList::GameList(Server* const server,const QString& labelText) :
-  description(labelText)
+  description(labelText),
+  model(this),
+  hoverTimer(this)
 {
   addWidget(&description,0,1,Qt::AlignCenter);
   addWidget(&lastUpdated,0,2,Qt::AlignRight);
 
-  QStringList m_TableHeader;
-  m_TableHeader<<sideWord(FIRST_SIDE)<<sideWord(SECOND_SIDE)<<tr("Time control");
-  tableWidget.setColumnCount(3);
-  tableWidget.setHorizontalHeaderLabels(m_TableHeader);
-  tableWidget.horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
-  tableWidget.horizontalHeader()->setStretchLastSection(true);
-  tableWidget.horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
-  tableWidget.verticalHeader()->setVisible(false);
-  tableWidget.setShowGrid(false);
-  tableWidget.setEditTriggers(QAbstractItemView::NoEditTriggers);
-  tableWidget.setFocusPolicy(Qt::NoFocus);
-  tableWidget.setSelectionMode(QAbstractItemView::NoSelection);
-  const int height=tableWidget.horizontalHeader()->height()+2;
-  tableWidget.setMaximumHeight(height);
-  tableWidget.setCursor(Qt::PointingHandCursor);
-  addWidget(&tableWidget,1,0,3,0,Qt::AlignTop);
-  connect(&tableWidget,&QTableWidget::itemClicked,this,[=](const QTableWidgetItem* item){
-    const auto& game=games[item->row()];
-    const auto column=item->column();
+  tableView.setModel(&model);
+  connect(&model,&GameListModel::rowsInserted,this,&GameList::updateHeight);
+  connect(&model,&GameListModel::rowsRemoved,this,&GameList::updateHeight);
+  tableView.horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+  tableView.horizontalHeader()->setStretchLastSection(true);
+  tableView.horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+  tableView.verticalHeader()->setVisible(false);
+  tableView.setShowGrid(false);
+  tableView.setEditTriggers(QAbstractItemView::NoEditTriggers);
+  tableView.setFocusPolicy(Qt::NoFocus);
+  tableView.setSelectionMode(QAbstractItemView::NoSelection);
+  updateHeight();
+  tableView.setCursor(Qt::PointingHandCursor);
+  addWidget(&tableView,1,0,3,0,Qt::AlignTop);
+  connect(&tableView,&QTableView::clicked,this,[=](const QModelIndex& index) {
+    const auto& game=model.game(index.row());
+    const auto column=index.column();
     const auto& self=server->session.username();
     const auto& players=game.players;
 
@@ -64,10 +67,23 @@ GameList::GameList(Server* const server,const QString& labelText) :
 
     server->enterGame(game,role,viewpoint);
   });
-  tableWidget.setContextMenuPolicy(Qt::CustomContextMenu);
-  connect(&tableWidget,&QTableWidget::customContextMenuRequested,this,[=](const QPoint pos){
-    QModelIndex index=tableWidget.indexAt(pos);
-    const auto& game=games[index.row()];
+  // Seat reservation and the first game state are fetched in advance for the game the cursor rests on.
+  tableView.setMouseTracking(true);
+  hoverTimer.setSingleShot(true);
+  connect(&tableView,&QTableView::entered,this,[this](const QModelIndex& index) {
+    hoveredIndex=index;
+    hoverTimer.start(HOVER_DELAY);
+  });
+  connect(&hoverTimer,&QTimer::timeout,this,[=] {
+    if (hoveredIndex.isValid() && tableView.underMouse())
+      server->prefetch(model.game(hoveredIndex.row()));
+  });
+  tableView.setContextMenuPolicy(Qt::CustomContextMenu);
+  connect(&tableView,&QTableView::customContextMenuRequested,this,[=](const QPoint pos){
+    const auto index=tableView.indexAt(pos);
+    if (!index.isValid())
+      return;
+    const auto& game=model.game(index.row());
 
     bool hasEmptySeat=false;
     bool hasOtherPlayer=false;
@@ -106,40 +122,139 @@ GameList::GameList(Server* const server,const QString& labelText) :
       menu->addAction(cancelGame);
     }
 
-    menu->popup(tableWidget.viewport()->mapToGlobal(pos));
+    menu->popup(tableView.viewport()->mapToGlobal(pos));
   });
 }
 
-void GameList::receiveGames(std::vector<ASIP::GameInfo> games_)
+void GameList::receiveGames(const std::vector<ASIP::GameInfo>& games)
+{
+  model.setGames(games);
+  lastUpdated.setText(tr("Last updated: ")+QDateTime::currentDateTime().toString("HH:mm:ss"));
+}
+
+void GameList::updateHeight()
+{
+  tableView.setMaximumHeight(tableView.horizontalHeader()->height()+2+model.rowCount()*tableView.verticalHeader()->defaultSectionSize());
+}
+
+GameListModel::GameListModel(QObject* const parent) :
+  QAbstractTableModel(parent)
+{
+}
+
+void GameListModel::setGames(const std::vector<ASIP::GameInfo>& newGames)
+{
+  QSet<QString> newIDs;
+  for (const auto& newGame:newGames)
+    newIDs.insert(newGame.id);
+  for (int row=static_cast<int>(games.size())-1;row>=0;) {
+    if (newIDs.contains(games[row].id))
+      --row;
+    else {
+      int first=row;
+      while (first>0 && !newIDs.contains(games[first-1].id))
+        --first;
+      beginRemoveRows(QModelIndex(),first,row);
+      games.erase(games.begin()+first,games.begin()+row+1);
+      endRemoveRows();
+      row=first-1;
+    }
+  }
+
+  QSet<QString> oldIDs;
+  for (const auto& game:games)
+    oldIDs.insert(game.id);
+  const int numNewGames=static_cast<int>(newGames.size());
+  for (int row=0;row<numNewGames;++row) {
+    const auto& newGame=newGames[row];
+    if (row<static_cast<int>(games.size()) && games[row].id==newGame.id) {
+      update(row,newGame);
+      continue;
+    }
+    const auto existing=(oldIDs.contains(newGame.id) ? std::find_if(games.begin()+std::min<size_t>(row,games.size()),games.end(),[&newGame](const ASIP::GameInfo& game) {
+      return game.id==newGame.id;
+    }) : games.end());
+    if (existing!=games.end()) {
+      const int from=static_cast<int>(existing-games.begin());
+      beginMoveRows(QModelIndex(),from,from,QModelIndex(),row);
+      const auto game=*existing;
+      games.erase(existing);
+      games.insert(games.begin()+row,game);
+      endMoveRows();
+      update(row,newGame);
+    }
+    else {
+      int last=row;
+      while (last+1<numNewGames && !oldIDs.contains(newGames[last+1].id))
+        ++last;
+      beginInsertRows(QModelIndex(),row,last);
+      games.insert(games.begin()+row,newGames.begin()+row,newGames.begin()+last+1);
+      endInsertRows();
+      row=last;
+    }
+  }
+  if (static_cast<int>(games.size())>numNewGames) {
+    beginRemoveRows(QModelIndex(),numNewGames,static_cast<int>(games.size())-1);
+    games.resize(numNewGames);
+    endRemoveRows();
+  }
+}
+
+const ASIP::GameInfo& GameListModel::game(const int row) const
+{
+  return games[row];
+}
+
+int GameListModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : static_cast<int>(games.size());
+}
+
+int GameListModel::columnCount(const QModelIndex& parent) const
 {
-  games.swap(games_);
-
-  tableWidget.setRowCount(static_cast<int>(games.size()));
-  unsigned int gameIndex=0;
-  for (const auto& game:games) {
-    for (Side side=FIRST_SIDE;side<NUM_SIDES;increment(side)) {
-      const auto& playerName=game.players[side];
-      auto playerItem=new QTableWidgetItem(playerName);
-      playerItem->setTextAlignment(Qt::AlignCenter);
-      if (playerName.isEmpty()) {
-        playerItem->setText("join");
-        auto font=playerItem->font();
+  return parent.isValid() ? 0 : NUM_COLUMNS;
+}
+
+QVariant GameListModel::data(const QModelIndex& index,const int role) const
+{
+  if (!index.isValid())
+    return QVariant();
+  const auto& game=games[index.row()];
+  const auto column=index.column();
+  switch (role) {
+    case Qt::DisplayRole:
+      if (column==TIME_CONTROL_COLUMN)
+        return game.timeControl;
+      else if (game.players[column].isEmpty())
+        return "join";
+      else
+        return game.players[column];
+    case Qt::FontRole:
+      if (column!=TIME_CONTROL_COLUMN && game.players[column].isEmpty()) {
+        QFont font;
         font.setItalic(true);
         font.setBold(true);
-        playerItem->setFont(font);
+        return font;
       }
-      tableWidget.setItem(gameIndex,side==FIRST_SIDE ? 0 : 1,playerItem);
-    }
-    auto timeControl=new QTableWidgetItem(game.timeControl);
-    timeControl->setTextAlignment(Qt::AlignCenter);
-    timeControl->setFlags(timeControl->flags()&~Qt::ItemIsSelectable);
-    tableWidget.setItem(gameIndex,2,timeControl);
-    ++gameIndex;
+    break;
+    case Qt::TextAlignmentRole:
+      return Qt::AlignCenter;
   }
+  return QVariant();
+}
 
-  int height=tableWidget.horizontalHeader()->height()+2;
-  for (int i=0;i<tableWidget.rowCount();++i)
-     height+=tableWidget.rowHeight(i);
-  tableWidget.setMaximumHeight(height);
-  lastUpdated.setText(tr("Last updated: ")+QDateTime::currentDateTime().toString("HH:mm:ss"));
+QVariant GameListModel::headerData(const int section,const Qt::Orientation orientation,const int role) const
+{
+  if (orientation==Qt::Horizontal && role==Qt::DisplayRole)
+    return section==TIME_CONTROL_COLUMN ? QCoreApplication::translate("GameList","Time control") : sideWord(static_cast<Side>(section));
+  return QVariant();
+}
+
+void GameListModel::update(const int row,const ASIP::GameInfo& newGame)
+{
+  auto& game=games[row];
+  const bool changed=(game.timeControl!=newGame.timeControl || !std::equal(std::begin(game.players),std::end(game.players),std::begin(newGame.players)));
+  game=newGame;
+  if (changed)
+    emit dataChanged(index(row,0),index(row,NUM_COLUMNS-1));
 }
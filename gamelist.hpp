@@ -3,19 +3,45 @@
 
 #include <QGridLayout>
 #include <QLabel>
-#include <QTableWidget>
+#include <QTableView>
+#include <QAbstractTableModel>
+#include <QTimer>
 class Server;
 #include "asip.hpp"
 
+class GameListModel : public QAbstractTableModel {
+public:
+  enum {TIME_CONTROL_COLUMN=NUM_SIDES,NUM_COLUMNS};
+
+  explicit GameListModel(QObject* const parent=nullptr);
+  void setGames(const std::vector<ASIP::GameInfo>& newGames);
+  const ASIP::GameInfo& game(const int row) const;
+
+  virtual int rowCount(const QModelIndex& parent=QModelIndex()) const override;
+  virtual int columnCount(const QModelIndex& parent=QModelIndex()) const override;
+  virtual QVariant data(const QModelIndex& index,const int role) const override;
+  virtual QVariant headerData(const int section,const Qt::Orientation orientation,const int role) const override;
+private:
+  void update(const int row,const ASIP::GameInfo& newGame);
+
+  std::vector<ASIP::GameInfo> games;
+};
+
 class GameList : public QGridLayout {
   Q_OBJECT
 public:
   explicit GameList(Server* const server,const QString& labelText);
-  void receiveGames(std::vector<ASIP::GameInfo> games_);
+  void receiveGames(const std::vector<ASIP::GameInfo>& games);
 private:
+  void updateHeight();
+
   QLabel description,lastUpdated;
-  QTableWidget tableWidget;
-  std::vector<ASIP::GameInfo> games;
+  GameListModel model;
+  QTableView tableView;
+  QTimer hoverTimer;
+  QPersistentModelIndex hoveredIndex;
+
+  static constexpr int HOVER_DELAY=300;
 
   friend class Server;
 };
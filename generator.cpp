@@ -0,0 +1,156 @@
+#include <map>
+#include <QCoreApplication>
+#include "generator.hpp"
+#include "workqueue.hpp"
+#include "solver.hpp"
+#include "io.hpp"
+
+int Generator::generate(const QString& archiveName,const QString& outputName,QTextStream& log)
+{
+  const auto games=readGames(archiveName);
+  QFile output(outputName);
+  runtime_assert(output.open(QIODevice::WriteOnly),output.errorString());
+
+  const auto numWorkers=Solver::defaultNumThreads();
+  WorkStealingQueue<std::function<void(const unsigned int)> > queue(numWorkers);
+  std::atomic<size_t> numInvalidGames(0),numPositions(0);
+  std::mutex output_mutex;
+  std::set<TurnState::Hash> written;
+
+  for (size_t gameIndex=0;gameIndex<games.size();++gameIndex)
+    queue.push(gameIndex,[&,gameIndex](const unsigned int worker) {
+      GameTree gameTree;
+      try {
+        gameTree=std::get<0>(toTree(games[gameIndex],Node::createTree().front()));
+      }
+      catch (const std::exception&) {
+        ++numInvalidGames;
+        return;
+      }
+      for (auto node=gameTree.front();node!=nullptr;node=node->previousNode)
+        if (!node->inSetup() && node->result.endCondition==NO_END && promising(node->gameState)) {
+          const TurnState turnState(node->gameState);
+          queue.push(worker,[&,turnState](const unsigned int) {
+            ++numPositions;
+            Puzzles::Puzzle puzzle;
+            try {
+              if (!findPuzzle(turnState,puzzle))
+                return;
+            }
+            catch (const std::exception&) {
+              return;
+            }
+            const auto hash=turnState.canonicalHash();
+            const auto puzzleData=Puzzles::toData(puzzle);
+            const std::lock_guard<std::mutex> lock(output_mutex);
+            if (written.insert(hash).second)
+              output.write(reinterpret_cast<const char*>(puzzleData.data()),puzzleData.size());
+          });
+        }
+    });
+
+  std::atomic<unsigned int> nextWorker(0);
+  Solver::runParallel(numWorkers,[&] {
+    queue.run(nextWorker++);
+  });
+
+  log<<QCoreApplication::translate("Generator","%1 game(s) read, %2 unreadable, %3 position(s) searched, %4 puzzle(s) written").arg(games.size()).arg(numInvalidGames).arg(numPositions).arg(written.size())<<'\n';
+  return EXIT_SUCCESS;
+}
+
+std::vector<std::string> Generator::readGames(const QString& archiveName)
+{
+  QFile file(archiveName);
+  runtime_assert(file.open(QIODevice::ReadOnly|QIODevice::Text),file.errorString());
+  std::vector<std::string> result;
+  int column=-1;
+  for (bool firstLine=true;!file.atEnd();firstLine=false) {
+    QString line=QString::fromUtf8(file.readLine());
+    if (line.endsWith('\n'))
+      line.chop(1);
+    const auto fields=line.split('\t');
+    if (firstLine) {
+      column=fields.indexOf("movelist");
+      if (column>=0)
+        continue;
+    }
+    QString moveList=(column<0 ? line : fields.value(column));
+    moveList.replace("\\n","\n");
+    if (!moveList.trimmed().isEmpty())
+      result.emplace_back(moveList.toStdString());
+  }
+  return result;
+}
+
+bool Generator::promising(const TurnState& turnState)
+{
+  const auto side=turnState.sideToMove;
+  for (SquareIndex square=FIRST_SQUARE;square<NUM_SQUARES;increment(square)) {
+    const auto piece=turnState.squarePieces[square];
+    if (piece==NO_PIECE)
+      continue;
+    else if (isSide(piece,side)) {
+      if (toPieceType(piece)==WINNING_PIECE_TYPE && std::abs(toRank(square)-(side==FIRST_SIDE ? NUM_RANKS-1 : 0))<=MAX_STEPS_PER_MOVE)
+        return true;
+    }
+    else if (toPieceType(piece)!=WINNING_PIECE_TYPE)
+      for (const auto trapSquare:getTrapSquares())
+        if (distance(square,trapSquare)<=MAX_STEPS_PER_MOVE/2)
+          return true;
+  }
+  return false;
+}
+
+bool Generator::findPuzzle(const TurnState& turnState,Puzzles::Puzzle& puzzle)
+{
+  const auto node=std::make_shared<Node>(nullptr,ExtendedSteps(),GameState(turnState));
+  if (node->result.endCondition!=NO_END)
+    return false;
+  const auto side=turnState.sideToMove;
+  const auto startingCounts=turnState.pieceCounts();
+
+  std::vector<ExtendedSteps> wins;
+  std::map<std::vector<PieceType>,std::pair<size_t,ExtendedSteps> > captures;
+  for (const auto& move:node->legalMoves()) {
+    const auto winner=Solver::result(node,move).winner;
+    if (winner==side) {
+      wins.emplace_back(move);
+      if (wins.size()>1)
+        return false;
+    }
+    else if (winner==NO_SIDE && wins.empty()) {
+      const auto pieceCounts=resultingState(move).pieceCounts();
+      std::vector<PieceType> captured;
+      bool lost=false;
+      for (PieceType pieceType=FIRST_PIECE_TYPE;pieceType<NUM_PIECE_TYPES;increment(pieceType)) {
+        if (pieceCounts[toPieceTypeAndSide(pieceType,side)]<startingCounts[toPieceTypeAndSide(pieceType,side)])
+          lost=true;
+        const auto opponentPiece=toPieceTypeAndSide(pieceType,otherSide(side));
+        captured.insert(captured.begin(),startingCounts[opponentPiece]-pieceCounts[opponentPiece],pieceType);
+      }
+      if (!lost && !captured.empty()) {
+        auto& capture=captures[captured];
+        if (capture.first++==0)
+          capture.second=move;
+      }
+    }
+  }
+
+  ExtendedSteps solution;
+  if (!wins.empty())
+    solution=wins.front();
+  else if (captures.empty())
+    return false;
+  else {
+    const auto& best=*captures.rbegin();
+    if (best.first.front()==WINNING_PIECE_TYPE || best.second.first!=1)
+      return false;
+    solution=best.second.second;
+  }
+
+  puzzle.first=turnState;
+  puzzle.second.clear();
+  for (const auto& step:solution)
+    puzzle.second.emplace_back(std::get<ORIGIN>(step),std::get<DESTINATION>(step));
+  return true;
+}
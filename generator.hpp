@@ -0,0 +1,16 @@
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include <QTextStream>
+#include "puzzles.hpp"
+
+class Generator {
+public:
+  static int generate(const QString& archiveName,const QString& outputName,QTextStream& log);
+  static std::vector<std::string> readGames(const QString& archiveName);
+private:
+  static bool promising(const TurnState& turnState);
+  static bool findPuzzle(const TurnState& turnState,Puzzles::Puzzle& puzzle);
+};
+
+#endif // GENERATOR_HPP
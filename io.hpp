@@ -438,10 +438,8 @@ inline std::tuple<GameTree,size_t> toTree(const std::string& input,NodePtr node,
   return make_tuple(gameTree,nodeChanges);
 }
 
-inline std::tuple<GameTree,size_t,bool> toTree(const std::string& input,const NodePtr& startingNode)
+inline std::tuple<GameTree,size_t,bool> toCompletedTree(const std::string& input,const NodePtr& startingNode,Placements setup,ExtendedSteps move)
 {
-  Placements setup;
-  ExtendedSteps move;
   auto result=toTree(input,startingNode,setup,move);
   auto& gameTree=std::get<0>(result);
   auto& node=gameTree.front();
@@ -464,6 +462,11 @@ inline std::tuple<GameTree,size_t,bool> toTree(const std::string& input,const No
   return make_tuple(gameTree,nodeChanges,completeLastMove);
 }
 
+inline std::tuple<GameTree,size_t,bool> toTree(const std::string& input,const NodePtr& startingNode)
+{
+  return toCompletedTree(input,startingNode,Placements(),ExtendedSteps());
+}
+
 inline TurnState customizedTurnState(const std::string& input,TurnState turnState=TurnState())
 {
   std::stringstream ss;
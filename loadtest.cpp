@@ -0,0 +1,104 @@
+#include <QCoreApplication>
+#include <QNetworkReply>
+#include "loadtest.hpp"
+#include "globals.hpp"
+#include "mainwindow.hpp"
+#include "asip1.hpp"
+#include "asip2.hpp"
+
+LoadTest::LoadTest(MainWindow& mainWindow_,const unsigned int numGames_,const int protocol,const QString& timeControl,const int botDelay,QTextStream& log_) :
+  QObject(&mainWindow_),
+  mainWindow(mainWindow_),
+  numGames(numGames_),
+  log(log_),
+  server(timeControl,botDelay,this),
+  numEntered(0),
+  numTimedEntries(0),
+  numUpdates(0),
+  numLagSamples(0),
+  totalLag(0),
+  maxLag(0),
+  lagTimer(this),
+  reportTimer(this)
+{
+  totalEntryTimes.fill(0);
+  server.listen();
+  auto& networkAccessManager=mainWindow.globals.networkAccessManager;
+  if (protocol==1)
+    session=new ASIP1(networkAccessManager,server.gameroomURL(protocol),this);
+  else
+    session=new ASIP2(networkAccessManager,server.gameroomURL(protocol),this);
+  const auto networkReply=session->login(this,"LoadTest",QString());
+  connect(networkReply,&QNetworkReply::finished,this,[this,networkReply] {
+    try {
+      session->processReply(*networkReply);
+      mainWindow.addServer(*session);
+      enterGames();
+    }
+    catch (const std::exception& exception) {
+      log<<exception.what()<<'\n';
+      log.flush();
+    }
+  });
+
+  lagTimer.setTimerType(Qt::PreciseTimer);
+  connect(&lagTimer,&QTimer::timeout,this,&LoadTest::measureLag);
+  lagTimer.start(LAG_INTERVAL);
+  lagClock.start();
+  connect(&reportTimer,&QTimer::timeout,this,&LoadTest::report);
+  reportTimer.start(REPORT_INTERVAL);
+  reportClock.start();
+}
+
+void LoadTest::enterGames()
+{
+  for (unsigned int gameIndex=0;gameIndex<numGames;++gameIndex)
+    session->enterGame(this,server.addBotGame(),NO_SIDE,[this](QNetworkReply* const networkReply) {
+      connect(networkReply,&QNetworkReply::finished,this,[this,networkReply] {
+        try {
+          const auto game=mainWindow.addGame(session->getGame(*networkReply),FIRST_SIDE,true);
+          connect(game,&ASIP::updated,this,[this]{++numUpdates;});
+          const QObject* const oneTime=new QObject(this);
+          connect(game,&ASIP::updated,oneTime,[this,game,oneTime] {
+            delete oneTime;
+            const auto entryTimes=game->getEntryTimes();
+            for (int entryPhase=0;entryPhase<ASIP::NUM_ENTRY_PHASES;++entryPhase)
+              totalEntryTimes[entryPhase]+=entryTimes[entryPhase];
+            ++numTimedEntries;
+          });
+          ++numEntered;
+        }
+        catch (const std::exception& exception) {
+          log<<exception.what()<<'\n';
+          log.flush();
+        }
+      });
+    });
+}
+
+void LoadTest::measureLag()
+{
+  const auto lag=std::max<qint64>(0,lagClock.restart()-LAG_INTERVAL);
+  totalLag+=lag;
+  maxLag=std::max(maxLag,lag);
+  ++numLagSamples;
+}
+
+void LoadTest::report()
+{
+  const auto seconds=reportClock.restart()/1000.0;
+  const auto& latency=session->latency();
+  log<<QCoreApplication::translate("LoadTest","%1 game(s), %2 update(s)/s, event loop lag %3 ms average, %4 ms maximum")
+       .arg(numEntered).arg(numUpdates/seconds,0,'f',1).arg(numLagSamples==0 ? 0 : double(totalLag)/numLagSamples,0,'f',1).arg(maxLag)<<'\n'
+     <<QCoreApplication::translate("LoadTest","Round trip %1/%2/%3 ms (50th/90th/99th percentile), jitter %4 ms")
+       .arg(latency.roundTripTimePercentile(0.5)).arg(latency.roundTripTimePercentile(0.9)).arg(latency.roundTripTimePercentile(0.99)).arg(latency.jitter())<<'\n';
+  if (numTimedEntries>0)
+    log<<QCoreApplication::translate("LoadTest","Joining took %1/%2/%3/%4 ms on average until seat reserved/seated/state received/board shown")
+         .arg(totalEntryTimes[ASIP::SEAT_RESERVED]/numTimedEntries).arg(totalEntryTimes[ASIP::SEATED]/numTimedEntries)
+         .arg(totalEntryTimes[ASIP::STATE_RECEIVED]/numTimedEntries).arg(totalEntryTimes[ASIP::BOARD_SHOWN]/numTimedEntries)<<'\n';
+  log.flush();
+  numUpdates=0;
+  numLagSamples=0;
+  totalLag=0;
+  maxLag=0;
+}
@@ -0,0 +1,36 @@
+#ifndef LOADTEST_HPP
+#define LOADTEST_HPP
+
+#include <array>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QTextStream>
+class MainWindow;
+#include "asip.hpp"
+#include "standinserver.hpp"
+
+class LoadTest : public QObject {
+public:
+  LoadTest(MainWindow& mainWindow_,const unsigned int numGames_,const int protocol,const QString& timeControl,const int botDelay,QTextStream& log_);
+private:
+  void enterGames();
+  void measureLag();
+  void report();
+
+  static constexpr int LAG_INTERVAL=100;
+  static constexpr int REPORT_INTERVAL=10*1000;
+
+  MainWindow& mainWindow;
+  const unsigned int numGames;
+  QTextStream& log;
+  StandInServer server;
+  ASIP* session;
+  unsigned int numEntered,numTimedEntries;
+  std::array<qint64,ASIP::NUM_ENTRY_PHASES> totalEntryTimes;
+  unsigned long long numUpdates,numLagSamples;
+  qint64 totalLag,maxLag;
+  QTimer lagTimer,reportTimer;
+  QElapsedTimer lagClock,reportClock;
+};
+
+#endif // LOADTEST_HPP
@@ -0,0 +1,143 @@
+#include <QFileInfo>
+#include <QInputDialog>
+#include "localgame.hpp"
+#include "globals.hpp"
+#include "messagebox.hpp"
+#include "io.hpp"
+
+LocalGame::LocalGame(Globals& globals_,const Side engineSide_,const Engine::Configuration& configuration,const int moveTime_,QWidget* const parent) :
+  Game(globals_,otherSide(engineSide_),parent),
+  engineSide(engineSide_),
+  moveTime(moveTime_),
+  engine(Engine::acquire(configuration)),
+  state(IDLE)
+{
+  setWindowTitle(tr("Game against %1").arg(QFileInfo(configuration.executable).completeBaseName()));
+  std::array<bool,NUM_SIDES> controllableSides;
+  controllableSides[engineSide]=false;
+  controllableSides[otherSide(engineSide)]=true;
+  board.setControllable(controllableSides);
+  liveNode=treeModel.root;
+  explore.setChecked(false);
+
+  moveTimer.setSingleShot(true);
+  connect(&moveTimer,&QTimer::timeout,this,[this]{engine->stop(false);});
+  connect(engine.get(),&Engine::receivedInfo,this,[this](const QString& type,const QString& value) {
+    if (state!=IDLE && type=="pv")
+      principalVariation=value;
+  });
+  connect(engine.get(),&Engine::receivedBestMove,this,&LocalGame::receiveBestMove);
+  connect(engine.get(),&Engine::failed,this,[this](const QString& message) {
+    state=IDLE;
+    moveTimer.stop();
+    MessageBox(QMessageBox::Critical,tr("Error from engine"),message,QMessageBox::NoButton,this).exec();
+  });
+  requestMove();
+}
+
+void LocalGame::start(Globals& globals,QWidget* const parent)
+{
+  const auto configuration=Engine::savedConfiguration(globals.settings);
+  if (configuration.executable.isEmpty()) {
+    MessageBox(QMessageBox::Critical,tr("Error starting game"),tr("No analysis executable has been set."),QMessageBox::NoButton,parent).exec();
+    return;
+  }
+  globals.settings.beginGroup("LocalGame");
+  const auto defaultSide=globals.settings.value("engine_side",SECOND_SIDE).toInt();
+  const auto defaultSeconds=globals.settings.value("seconds_per_move",10).toInt();
+  globals.settings.endGroup();
+
+  bool ok;
+  const QStringList sides{sideWord(FIRST_SIDE),sideWord(SECOND_SIDE)};
+  const auto engineSide=static_cast<Side>(sides.indexOf(QInputDialog::getItem(parent,tr("Play against engine"),tr("Engine plays:"),sides,defaultSide,false,&ok)));
+  if (!ok)
+    return;
+  const auto seconds=QInputDialog::getInt(parent,tr("Play against engine"),tr("Seconds per move:"),defaultSeconds,1,24*60*60,1,&ok);
+  if (!ok)
+    return;
+  globals.settings.beginGroup("LocalGame");
+  globals.settings.setValue("engine_side",engineSide);
+  globals.settings.setValue("seconds_per_move",seconds);
+  globals.settings.endGroup();
+
+  (new LocalGame(globals,engineSide,configuration,seconds*1000,parent))->show();
+}
+
+void LocalGame::receiveNodeChange(const NodePtr& newNode)
+{
+  if (!board.explore)
+    liveNode=newNode;
+  Game::receiveNodeChange(newNode);
+  if (!board.explore)
+    requestMove();
+}
+
+void LocalGame::requestMove()
+{
+  if (liveNode->gameState.sideToMove!=engineSide || liveNode->result.endCondition!=NO_END)
+    return;
+  const bool ponderHit=(state==PONDERING &&
+                        ponderNode->gameState==liveNode->gameState &&
+                        ponderNode->previousNode->gameState==liveNode->previousNode->gameState);
+  state=THINKING;
+  if (!ponderHit) {
+    principalVariation.clear();
+    engine->analyze(liveNode);
+    moveTimer.start(moveTime);
+  }
+  else if (ponderedMove.isEmpty())
+    moveTimer.start(std::max<qint64>(0,moveTime-ponderTimer.elapsed()));
+  else
+    playMove(ponderedMove);
+}
+
+void LocalGame::receiveBestMove(const QString& move)
+{
+  if (state==PONDERING)
+    ponderedMove=move;
+  else if (state==THINKING)
+    playMove(move);
+}
+
+void LocalGame::playMove(const QString& move)
+{
+  moveTimer.stop();
+  state=IDLE;
+  const auto previousNode=liveNode;
+  const auto newNode=Engine::applyMove(previousNode,move);
+  if (newNode==nullptr) {
+    MessageBox(QMessageBox::Critical,tr("Error from engine"),tr("Illegal move: %1").arg(move),QMessageBox::NoButton,this).exec();
+    return;
+  }
+  receiveGameTree(GameTree(1,newNode),false);
+  ponder(predictedReply(previousNode));
+}
+
+void LocalGame::ponder(const NodePtr& node)
+{
+  ponderNode=node;
+  ponderedMove.clear();
+  principalVariation.clear();
+  if (ponderNode!=nullptr && ponderNode->result.endCondition==NO_END) {
+    state=PONDERING;
+    engine->analyze(ponderNode);
+    ponderTimer.start();
+  }
+}
+
+NodePtr LocalGame::predictedReply(const NodePtr& node) const
+{
+  if (principalVariation.isEmpty())
+    return nullptr;
+  try {
+    auto reply=std::get<0>(toTree(principalVariation.toStdString(),Node::reroot(node))).front();
+    if (reply->depth<node->depth+2)
+      return nullptr;
+    while (reply->depth>node->depth+2)
+      reply=reply->previousNode;
+    return reply->previousNode->gameState==liveNode->gameState ? reply : nullptr;
+  }
+  catch (const std::exception&) {
+    return nullptr;
+  }
+}
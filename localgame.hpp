@@ -0,0 +1,29 @@
+#ifndef LOCALGAME_HPP
+#define LOCALGAME_HPP
+
+#include <QElapsedTimer>
+#include "game.hpp"
+
+class LocalGame : public Game {
+public:
+  LocalGame(Globals& globals_,const Side engineSide_,const Engine::Configuration& configuration,const int moveTime_,QWidget* const parent=nullptr);
+  static void start(Globals& globals,QWidget* const parent);
+private:
+  virtual void receiveNodeChange(const NodePtr& newNode) override;
+  void requestMove();
+  void receiveBestMove(const QString& move);
+  void playMove(const QString& move);
+  void ponder(const NodePtr& node);
+  NodePtr predictedReply(const NodePtr& node) const;
+
+  const Side engineSide;
+  const int moveTime;
+  const std::shared_ptr<Engine> engine;
+  enum {IDLE,THINKING,PONDERING} state;
+  NodePtr ponderNode;
+  QString principalVariation,ponderedMove;
+  QElapsedTimer ponderTimer;
+  QTimer moveTimer;
+};
+
+#endif // LOCALGAME_HPP
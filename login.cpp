@@ -73,21 +73,8 @@ Login::Login(Globals& globals_,MainWindow& mainWindow_) :
       }
     }
     setEnabled(false);
-    ASIP* asip;
-    const bool arimaa_com=(gameroomHost=="arimaa.com");
-    if (protocolButtons[0]->isChecked()) {
-      if (arimaa_com)
-        asip=new Arimaa_com<ASIP1>(globals.networkAccessManager,gameroomURL,this);
-      else
-        asip=new ASIP1(globals.networkAccessManager,gameroomURL,this);
-    }
-    else {
-      assert(protocolButtons[1]->isChecked());
-      if (arimaa_com)
-        asip=new Arimaa_com<ASIP2>(globals.networkAccessManager,gameroomURL,this);
-      else
-        asip=new ASIP2(globals.networkAccessManager,gameroomURL,this);
-    }
+    assert(protocolButtons[0]->isChecked() || protocolButtons[1]->isChecked());
+    const auto asip=newSession(globals.networkAccessManager,gameroomURL,protocolButtons[0]->isChecked() ? 1 : 2,this);
     const auto networkReply=asip->login(this,usernameString,password.text());
     connect(networkReply,&QNetworkReply::finished,this,[=]{loginAttempt(*networkReply,*asip);});
   });
@@ -95,6 +82,23 @@ Login::Login(Globals& globals_,MainWindow& mainWindow_) :
   vBoxLayout.addWidget(&dialogButtonBox);
 }
 
+ASIP* Login::newSession(QNetworkAccessManager& networkAccessManager,const QString& gameroomURL,const int protocol,QObject* const parent)
+{
+  const bool arimaa_com=(QUrl(gameroomURL).host()=="arimaa.com");
+  if (protocol==1) {
+    if (arimaa_com)
+      return new Arimaa_com<ASIP1>(networkAccessManager,gameroomURL,parent);
+    else
+      return new ASIP1(networkAccessManager,gameroomURL,parent);
+  }
+  else {
+    if (arimaa_com)
+      return new Arimaa_com<ASIP2>(networkAccessManager,gameroomURL,parent);
+    else
+      return new ASIP2(networkAccessManager,gameroomURL,parent);
+  }
+}
+
 void Login::loginAttempt(QNetworkReply& networkReply,ASIP& asip)
 {
   try {
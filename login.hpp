@@ -3,6 +3,7 @@
 
 #include <array>
 #include <memory>
+class QNetworkAccessManager;
 class QNetworkReply;
 #include <QDialog>
 #include <QFormLayout>
@@ -18,6 +19,7 @@ class Login : public QDialog {
   Q_OBJECT
 public:
   explicit Login(Globals& globals_,MainWindow& mainWindow_);
+  static ASIP* newSession(QNetworkAccessManager& networkAccessManager,const QString& gameroomURL,const int protocol,QObject* const parent);
 private:
   void loginAttempt(QNetworkReply& networkReply,ASIP& asip);
 
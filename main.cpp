@@ -1,13 +1,102 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
 #include <QStyle>
 #include <QScreen>
 #include "globals.hpp"
 #include "mainwindow.hpp"
 #include "iconengine.hpp"
+#include "puzzles.hpp"
+#include "generator.hpp"
+#include "montecarlo.hpp"
+#include "tournament.hpp"
+#include "standinserver.hpp"
+#include "loadtest.hpp"
+#include "sessionlog.hpp"
+
+static bool headless(const int argc,char* argv[])
+{
+  const QStringList headlessOptions={"--check-puzzles","--generate-puzzles","--estimate-win-rates","--tournament","--stand-in-server"};
+  for (int argIndex=1;argIndex<argc;++argIndex)
+    if (headlessOptions.contains(QString(argv[argIndex]).section('=',0,0)))
+      return true;
+  return false;
+}
 
 int main(int argc,char* argv[])
 {
-  const QApplication a(argc,argv);
+  const std::unique_ptr<QCoreApplication> a(headless(argc,argv) ? new QCoreApplication(argc,argv) : new QApplication(argc,argv));
+
+  QCommandLineParser parser;
+  parser.addHelpOption();
+  const QCommandLineOption checkPuzzles("check-puzzles",QCoreApplication::translate("main","Verify that every puzzle in <file> has exactly one solution and no symmetric duplicate."),"file");
+  parser.addOption(checkPuzzles);
+  const QCommandLineOption generatePuzzles("generate-puzzles",QCoreApplication::translate("main","Mine puzzles with unique solutions from game <archive>."),"archive");
+  parser.addOption(generatePuzzles);
+  const QCommandLineOption estimateWinRates("estimate-win-rates",QCoreApplication::translate("main","Label every position in game <archive> with random playout win rates."),"archive");
+  parser.addOption(estimateWinRates);
+  const QCommandLineOption playouts("playouts",QCoreApplication::translate("main","Play <number> random games per labeled position."),"number","1000");
+  parser.addOption(playouts);
+  const QCommandLineOption tournament("tournament",QCoreApplication::translate("main","Play a round robin between the AEI engines listed one command line per row in <file>."),"file");
+  parser.addOption(tournament);
+  const QCommandLineOption standInServer("stand-in-server",QCoreApplication::translate("main","Serve a local ASIP 1.0 and 2.0 stand-in on <port> with random bots for testing."),"port");
+  parser.addOption(standInServer);
+  const QCommandLineOption loadTest("load-test",QCoreApplication::translate("main","Spectate <number> bot games on an in-process stand-in server and report event loop lag."),"number");
+  parser.addOption(loadTest);
+  const QCommandLineOption protocol("protocol",QCoreApplication::translate("main","Use ASIP <version> for the load test."),"version","2");
+  parser.addOption(protocol);
+  const QCommandLineOption botDelay("bot-delay",QCoreApplication::translate("main","Let stand-in bots move after <milliseconds>."),"milliseconds","1000");
+  parser.addOption(botDelay);
+  const QCommandLineOption timeControl("time-control",QCoreApplication::translate("main","Play tournament and stand-in games at time control <tc>."),"tc","15s/1m/100/2m");
+  parser.addOption(timeControl);
+  const QCommandLineOption games("games",QCoreApplication::translate("main","Play <number> tournament games per pairing, or host <number> bot games on the stand-in server."),"number","2");
+  parser.addOption(games);
+  const QCommandLineOption recordSession("record-session",QCoreApplication::translate("main","Record every game room and game server exchange to <file>."),"file");
+  parser.addOption(recordSession);
+  const QCommandLineOption replaySession("replay-session",QCoreApplication::translate("main","Replay the exchanges recorded in <file> instead of using the network."),"file");
+  parser.addOption(replaySession);
+  const QCommandLineOption replaySpeed("replay-speed",QCoreApplication::translate("main","Replay sessions <factor> times faster than recorded."),"factor","1");
+  parser.addOption(replaySpeed);
+  const QCommandLineOption output("output",QCoreApplication::translate("main","Write generated data to <file>."),"file");
+  parser.addOption(output);
+  parser.process(*a);
+
+  if (headless(argc,argv)) {
+    QTextStream standardOutput(stdout);
+    try {
+      if (parser.isSet(checkPuzzles))
+        return Puzzles::checkFile(parser.value(checkPuzzles),standardOutput);
+      else if (parser.isSet(standInServer)) {
+        bool ok,ok2,ok3;
+        const auto port=parser.value(standInServer).toUShort(&ok);
+        const auto numGames=parser.value(games).toUInt(&ok2);
+        const auto delay=parser.value(botDelay).toInt(&ok3);
+        runtime_assert(ok && ok2 && ok3 && delay>=0,"Invalid stand-in server settings.");
+        return StandInServer::run(port,parser.value(timeControl),numGames,delay,standardOutput);
+      }
+      else {
+        runtime_assert(parser.isSet(output),"No output file specified.");
+        if (parser.isSet(tournament)) {
+          bool ok;
+          const auto numGames=parser.value(games).toUInt(&ok);
+          runtime_assert(ok && numGames>0,"Invalid number of games.");
+          return Tournament::run(parser.value(tournament),parser.value(timeControl),numGames,parser.value(output),standardOutput);
+        }
+        else if (parser.isSet(estimateWinRates)) {
+          bool ok;
+          const auto numPlayouts=parser.value(playouts).toULongLong(&ok);
+          runtime_assert(ok && numPlayouts>0,"Invalid number of playouts.");
+          return MonteCarlo::label(parser.value(estimateWinRates),parser.value(output),numPlayouts,standardOutput);
+        }
+        else
+          return Generator::generate(parser.value(generatePuzzles),parser.value(output),standardOutput);
+      }
+    }
+    catch (const std::exception& exception) {
+      QTextStream(stderr)<<exception.what()<<'\n';
+      return EXIT_FAILURE;
+    }
+  }
 
   std::random_device rd;
   Globals globals(rd()^time(nullptr),"4steps.ini",QSettings::IniFormat);
@@ -16,5 +105,29 @@ int main(int argc,char* argv[])
   QApplication::setWindowIcon(QIcon(new IconEngine));
   mainWindow.show();
 
-  return a.exec();
+  QTextStream standardOutput(stdout);
+  try {
+    if (parser.isSet(recordSession))
+      SessionLog::record(parser.value(recordSession));
+    else if (parser.isSet(replaySession)) {
+      bool ok;
+      const auto speed=parser.value(replaySpeed).toDouble(&ok);
+      runtime_assert(ok && speed>0,"Invalid replay speed.");
+      SessionLog::replay(parser.value(replaySession),speed,mainWindow);
+    }
+    if (parser.isSet(loadTest)) {
+      bool ok,ok2,ok3;
+      const auto numGames=parser.value(loadTest).toUInt(&ok);
+      const auto version=parser.value(protocol).toInt(&ok2);
+      const auto delay=parser.value(botDelay).toInt(&ok3);
+      runtime_assert(ok && ok2 && ok3 && (version==1 || version==2) && delay>=0,"Invalid load test settings.");
+      new LoadTest(mainWindow,numGames,version,parser.value(timeControl),delay,standardOutput);
+    }
+  }
+  catch (const std::exception& exception) {
+    QTextStream(stderr)<<exception.what()<<'\n';
+    return EXIT_FAILURE;
+  }
+
+  return a->exec();
 }
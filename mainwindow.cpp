@@ -4,6 +4,7 @@
 #include "mainwindow.hpp"
 #include "globals.hpp"
 #include "game.hpp"
+#include "localgame.hpp"
 #include "login.hpp"
 #include "puzzles.hpp"
 #include "server.hpp"
@@ -13,6 +14,7 @@ MainWindow::MainWindow(Globals& globals_,QWidget* const parent) :
   globals(globals_),
   emptyGame(tr("Edit &new game")),
   customGame(tr("Set up &custom position")),
+  engineGame(tr("Play against &engine")),
   logIn(tr("&Log in")),
   quit(tr("&Quit")),
   chat(tr("Enter &chat (Discord server)")),
@@ -30,6 +32,10 @@ MainWindow::MainWindow(Globals& globals_,QWidget* const parent) :
   connect(&customGame,&QAction::triggered,this,[this]{(new Game(globals,FIRST_SIDE,this,nullptr,make_unique<TurnState>()))->show();});
   menu->addAction(&customGame);
 
+  engineGame.setShortcut(QKeySequence(Qt::CTRL+Qt::Key_E));
+  connect(&engineGame,&QAction::triggered,this,[this]{LocalGame::start(globals,this);});
+  menu->addAction(&engineGame);
+
   logIn.setShortcut(QKeySequence(Qt::CTRL+Qt::Key_L));
   connect(&logIn,&QAction::triggered,this,[this]{openDialog(new Login(globals,*this));});
   menu->addAction(&logIn);
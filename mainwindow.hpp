@@ -22,7 +22,7 @@ public:
   std::vector<Server*> servers;
   Globals& globals;
 private:
-  QAction emptyGame,customGame,logIn,quit,chat;
+  QAction emptyGame,customGame,engineGame,logIn,quit,chat;
   QLabel buildTime;
   std::vector<std::weak_ptr<ASIP> > games;
 };
@@ -0,0 +1,178 @@
+#include <atomic>
+#include <QCoreApplication>
+#include <QFile>
+#include "montecarlo.hpp"
+#include "generator.hpp"
+#include "workqueue.hpp"
+#include "io.hpp"
+
+MonteCarlo::MonteCarlo(NodePtr node_,const unsigned int maxPlies_) :
+  node(std::move(node_)),
+  maxPlies(maxPlies_)
+{
+  for (auto currentNode=node;currentNode!=nullptr;currentNode=currentNode->previousNode) {
+    ++history[currentNode->gameState.hash()];
+    if (currentNode->move.empty())
+      break;
+  }
+}
+
+MonteCarlo::Estimate MonteCarlo::estimate(const unsigned long long numPlayouts,const unsigned int numThreads) const
+{
+  Estimate result{0,{0,0}};
+  std::atomic<unsigned long long> nextPlayout(0);
+  std::random_device randomDevice;
+  std::atomic<unsigned int> nextSeed(randomDevice());
+  std::mutex result_mutex;
+  Solver::runParallel(std::max<unsigned long long>(1,std::min<unsigned long long>(numThreads,numPlayouts)),[&] {
+    std::mt19937_64 generator(nextSeed++);
+    Estimate local{0,{0,0}};
+    for (;nextPlayout++<numPlayouts;++local.numPlayouts) {
+      const auto winner=playout(generator).winner;
+      if (winner!=NO_SIDE)
+        ++local.wins[winner];
+    }
+    const std::lock_guard<std::mutex> lock(result_mutex);
+    result.numPlayouts+=local.numPlayouts;
+    for (Side side=FIRST_SIDE;side<NUM_SIDES;increment(side))
+      result.wins[side]+=local.wins[side];
+  });
+  return result;
+}
+
+Result MonteCarlo::playout(std::mt19937_64& generator) const
+{
+  if (node->result.endCondition!=NO_END)
+    return node->result;
+  assert(!node->inSetup());
+  GameState gameState(node->gameState);
+  auto occurrences=history;
+  for (unsigned int ply=0;ply<maxPlies;++ply) {
+    if (!playMove(gameState,occurrences,generator))
+      return {otherSide(gameState.sideToMove),IMMOBILIZATION};
+    gameState.switchTurn();
+    ++occurrences[gameState.hash()];
+    const auto result=Node::goalOrElimination(gameState);
+    if (result.endCondition!=NO_END)
+      return result;
+  }
+  return {NO_SIDE,NO_END};
+}
+
+bool MonteCarlo::playMove(GameState& gameState,const Occurrences& occurrences,std::mt19937_64& generator) const
+{
+  // Same move rules as Node::legalMove, with repetitions counted over the game so far and the playout.
+  const GameState start(gameState);
+  const Side side=start.sideToMove;
+  const int goalRank=(side==FIRST_SIDE ? NUM_RANKS-1 : 0);
+  const int approachRank=(side==FIRST_SIDE ? goalRank-1 : goalRank+1);
+  std::uniform_int_distribution<int> squareDistribution(FIRST_SQUARE,NUM_SQUARES-1);
+  std::uniform_int_distribution<int> directionDistribution(0,NUM_DIRECTIONS-1);
+  std::uniform_int_distribution<int> endDistribution(0,END_ODDS-1);
+  for (unsigned int attempt=0;attempt<MAX_MOVE_ATTEMPTS;++attempt) {
+    gameState=start;
+    while (gameState.stepsAvailable>0) {
+      for (int file=0;file<NUM_FILES;++file) {
+        const auto origin=static_cast<SquareIndex>(file+approachRank*NUM_FILES);
+        const auto destination=static_cast<SquareIndex>(file+goalRank*NUM_FILES);
+        if (gameState.squarePieces[origin]==toPieceTypeAndSide(WINNING_PIECE_TYPE,side) && gameState.legalStep(origin,destination)) {
+          gameState.takeStep(origin,destination);
+          return true;
+        }
+      }
+      const bool canEnd=!gameState.inPush && gameState.squarePieces!=start.squarePieces && !repeats(gameState,occurrences);
+      if (canEnd && endDistribution(generator)==0)
+        return true;
+
+      Step step(NO_SQUARE,NO_SQUARE);
+      for (unsigned int sample=0;sample<MAX_STEP_SAMPLES && step.first==NO_SQUARE;++sample) {
+        const auto origin=static_cast<SquareIndex>(squareDistribution(generator));
+        const auto destination=toDestination(origin,static_cast<Direction>(directionDistribution(generator)),false);
+        if (destination!=NO_SQUARE && gameState.legalStep(origin,destination))
+          step=Step(origin,destination);
+      }
+      if (step.first==NO_SQUARE) {
+        Steps steps;
+        for (SquareIndex origin=FIRST_SQUARE;origin<NUM_SQUARES;increment(origin))
+          for (const auto destination:adjacentSquares(origin))
+            if (gameState.legalStep(origin,destination))
+              steps.emplace_back(origin,destination);
+        if (steps.empty())
+          break;
+        step=steps[std::uniform_int_distribution<size_t>(0,steps.size()-1)(generator)];
+      }
+      gameState.takeStep(step.first,step.second);
+    }
+    if (!gameState.inPush && gameState.squarePieces!=start.squarePieces && !repeats(gameState,occurrences))
+      return true;
+  }
+  // Random walks can miss the only moves there are, so confirm immobilization exhaustively.
+  gameState=start;
+  return playAnyMove(start,gameState,occurrences);
+}
+
+bool MonteCarlo::playAnyMove(const GameState& start,GameState& gameState,const Occurrences& occurrences)
+{
+  const GameState current(gameState);
+  for (SquareIndex origin=FIRST_SQUARE;origin<NUM_SQUARES;increment(origin))
+    for (const auto destination:adjacentSquares(origin))
+      if (current.legalStep(origin,destination)) {
+        gameState=current;
+        gameState.takeStep(origin,destination);
+        if ((!gameState.inPush && gameState.squarePieces!=start.squarePieces && !repeats(gameState,occurrences)) || playAnyMove(start,gameState,occurrences))
+          return true;
+      }
+  gameState=current;
+  return false;
+}
+
+bool MonteCarlo::repeats(const GameState& gameState,const Occurrences& occurrences)
+{
+  const auto occurrence=occurrences.find(TurnState(otherSide(gameState.sideToMove),gameState.squarePieces).hash());
+  return occurrence!=occurrences.end() && occurrence->second>MAX_ALLOWED_REPETITIONS;
+}
+
+int MonteCarlo::label(const QString& archiveName,const QString& outputName,const unsigned long long numPlayouts,QTextStream& log)
+{
+  const auto games=Generator::readGames(archiveName);
+  QFile output(outputName);
+  runtime_assert(output.open(QIODevice::WriteOnly|QIODevice::Text),output.errorString());
+
+  const auto numWorkers=Solver::defaultNumThreads();
+  WorkStealingQueue<std::function<void(const unsigned int)> > queue(numWorkers);
+  std::atomic<size_t> numInvalidGames(0),numPositions(0);
+  std::vector<std::string> lines(games.size());
+
+  for (size_t gameIndex=0;gameIndex<games.size();++gameIndex)
+    queue.push(gameIndex,[&,gameIndex](const unsigned int) {
+      GameTree gameTree;
+      try {
+        gameTree=std::get<0>(toTree(games[gameIndex],Node::createTree().front()));
+      }
+      catch (const std::exception&) {
+        ++numInvalidGames;
+        return;
+      }
+      auto& line=lines[gameIndex];
+      for (const auto& weakNode:Node::selfAndAncestors(gameTree.front())) {
+        const auto node=weakNode.lock();
+        if (node->inSetup())
+          continue;
+        ++numPositions;
+        const auto estimate=MonteCarlo(node).estimate(numPlayouts,1);
+        line=std::to_string(gameIndex+1)+'\t'+node->nextPlyString()+'\t'+std::to_string(estimate.winRate(FIRST_SIDE))+'\t'+std::to_string(estimate.winRate(SECOND_SIDE))+'\n'+line;
+      }
+    });
+
+  std::atomic<unsigned int> nextWorker(0);
+  Solver::runParallel(numWorkers,[&] {
+    queue.run(nextWorker++);
+  });
+
+  output.write("game\tmove\tgold\tsilver\n");
+  for (const auto& line:lines)
+    output.write(line.data(),line.size());
+
+  log<<QCoreApplication::translate("MonteCarlo","%1 game(s) read, %2 unreadable, %3 position(s) labeled with %4 playout(s) each").arg(games.size()).arg(numInvalidGames).arg(numPositions).arg(numPlayouts)<<'\n';
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,39 @@
+#ifndef MONTECARLO_HPP
+#define MONTECARLO_HPP
+
+#include <random>
+#include <unordered_map>
+#include <QTextStream>
+#include "solver.hpp"
+
+class MonteCarlo {
+public:
+  struct Estimate {
+    unsigned long long numPlayouts;
+    std::array<unsigned long long,NUM_SIDES> wins;
+
+    double winRate(const Side side) const {return numPlayouts==0 ? 0 : double(wins[side])/numPlayouts;}
+  };
+
+  explicit MonteCarlo(NodePtr node_,const unsigned int maxPlies_=DEFAULT_MAX_PLIES);
+  Estimate estimate(const unsigned long long numPlayouts,const unsigned int numThreads=Solver::defaultNumThreads()) const;
+  Result playout(std::mt19937_64& generator) const;
+  static int label(const QString& archiveName,const QString& outputName,const unsigned long long numPlayouts,QTextStream& log);
+
+  static constexpr unsigned int DEFAULT_MAX_PLIES=200;
+private:
+  typedef std::unordered_map<TurnState::Hash,unsigned int> Occurrences;
+
+  bool playMove(GameState& gameState,const Occurrences& occurrences,std::mt19937_64& generator) const;
+  static bool playAnyMove(const GameState& start,GameState& gameState,const Occurrences& occurrences);
+  static bool repeats(const GameState& gameState,const Occurrences& occurrences);
+
+  static constexpr unsigned int MAX_MOVE_ATTEMPTS=8;
+  static constexpr unsigned int MAX_STEP_SAMPLES=32;
+  static constexpr int END_ODDS=8;
+  const NodePtr node;
+  const unsigned int maxPlies;
+  Occurrences history;
+};
+
+#endif // MONTECARLO_HPP
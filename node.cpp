@@ -6,7 +6,8 @@ Node::Node(NodePtr previousNode_,const ExtendedSteps& move_,const GameState& gam
   move(move_),
   depth(previousNode==nullptr ? 0 : previousNode->depth+1),
   gameState(gameState_),
-  result(detectGameEnd())
+  result(detectGameEnd()),
+  threats(0)
 {
 }
 
@@ -140,11 +141,45 @@ bool Node::hasLegalMoves(const GameState& startingState) const
   return false;
 }
 
+std::vector<ExtendedSteps> Node::legalMoves(const ExtendedSteps& prefix) const
+{
+  assert(!inSetup());
+  std::vector<ExtendedSteps> result;
+  std::set<GameState::Board> resultingBoards;
+  std::set<std::tuple<GameState::Board,int,bool,SquareIndex,std::set<SquareIndex> > > visited;
+  ExtendedSteps move(prefix);
+  const std::function<void(const GameState&)> expand=[&](const GameState& state) {
+    if (!visited.emplace(state.squarePieces,state.stepsAvailable,state.inPush,state.followupDestination,state.followupOrigins).second)
+      return;
+    if (!move.empty() && legalMove(state)==MoveLegality::LEGAL && resultingBoards.insert(state.squarePieces).second)
+      result.emplace_back(move);
+    for (SquareIndex origin=FIRST_SQUARE;origin<NUM_SQUARES;increment(origin))
+      for (const SquareIndex adjacentSquare:adjacentSquares(origin))
+        if (state.legalStep(origin,adjacentSquare)) {
+          GameState changedState(state);
+          move.emplace_back(changedState.takeExtendedStep(origin,adjacentSquare));
+          expand(changedState);
+          move.pop_back();
+        }
+  };
+  expand(move.empty() ? gameState : resultingState(move));
+  return result;
+}
+
 Result Node::detectGameEnd() const
 {
   if (inSetup())
     return {NO_SIDE,NO_END};
   assert(gameState.stepsAvailable==MAX_STEPS_PER_MOVE);
+  const auto result=goalOrElimination(gameState);
+  if (result.endCondition!=NO_END || hasLegalMoves(gameState))
+    return result;
+  else
+    return {otherSide(gameState.sideToMove),IMMOBILIZATION};
+}
+
+Result Node::goalOrElimination(const GameState& gameState)
+{
   bool goal[NUM_SIDES]={false,false};
   bool eliminated[NUM_SIDES]={true,true};
   for (SquareIndex square=FIRST_SQUARE;square<NUM_SQUARES;increment(square)) {
@@ -167,10 +202,7 @@ Result Node::detectGameEnd() const
     else if (eliminated[otherSide(side)])
       return {side,ELIMINATION};
   }
-  if (hasLegalMoves(gameState))
-    return {NO_SIDE,NO_END};
-  else
-    return {playedSide,IMMOBILIZATION};
+  return {NO_SIDE,NO_END};
 }
 
 int Node::childIndex() const
@@ -3,9 +3,17 @@
 
 #include <memory>
 #include <mutex>
+#include <functional>
 #include "gamestate.hpp"
 
 struct Node {
+  enum Threat {
+    GOAL_THREAT=1,
+    CAPTURE_THREAT=2,
+    MISSED_WIN=4,
+    THREATS_SCANNED=8
+  };
+
   const NodePtr previousNode;
   ExtendedSteps move;
   const int depth;
@@ -13,6 +21,8 @@ struct Node {
   const Result result;
   mutable std::list<std::weak_ptr<Node> > children;
   mutable std::mutex children_mutex;
+  mutable std::string score,bestMove;
+  mutable unsigned int threats;
 
   explicit Node(NodePtr previousNode_,const ExtendedSteps& move_,const GameState& gameState_);
   const Node& root() const;
@@ -31,7 +41,9 @@ struct Node {
   MoveLegality legalMove(const ExtendedSteps& move) const;
   bool legalPartialMove(const ExtendedSteps& move) const;
   bool hasLegalMoves(const GameState& startingState) const;
+  std::vector<ExtendedSteps> legalMoves(const ExtendedSteps& prefix=ExtendedSteps()) const;
   Result detectGameEnd() const;
+  static Result goalOrElimination(const GameState& gameState);
   int childIndex() const;
   int cumulativeChildIndex() const;
   NodePtr child(const int index) const;
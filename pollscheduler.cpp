@@ -0,0 +1,128 @@
+#include <QCoreApplication>
+#include "pollscheduler.hpp"
+#include "asip.hpp"
+
+std::map<QUrl,PollScheduler*> PollScheduler::schedulers;
+
+PollScheduler::PollScheduler() :
+  QObject(QCoreApplication::instance()),
+  timer(this)
+{
+  timer.setSingleShot(true);
+  connect(&timer,&QTimer::timeout,this,&PollScheduler::schedule);
+}
+
+PollScheduler& PollScheduler::of(const ASIP& session)
+{
+  auto& scheduler=schedulers[session.serverURL()];
+  if (scheduler==nullptr)
+    scheduler=new PollScheduler();
+  return *scheduler;
+}
+
+void PollScheduler::enqueue(ASIP& session)
+{
+  auto& entry_=entry(session);
+  entry_.waiting=true;
+  entry_.longPolling=false;
+  entry_.sinceLastPoll.start();
+  schedule();
+}
+
+void PollScheduler::remove(ASIP& session)
+{
+  const auto existing=sessions.find(&session);
+  if (existing!=sessions.end()) {
+    existing->second.waiting=false;
+    existing->second.longPolling=false;
+    schedule();
+  }
+}
+
+void PollScheduler::setShown(ASIP& session,const bool shown)
+{
+  auto& entry_=entry(session);
+  if (shown)
+    ++entry_.numViews;
+  else if (entry_.numViews>0) {
+    --entry_.numViews;
+    // A hidden spectator would hold on to its long poll slot until the server answers, so poll it as hidden instead.
+    if (entry_.numViews==0 && entry_.longPolling && priority(session,entry_)==HIDDEN) {
+      session.abortPoll();
+      entry_.waiting=true;
+      entry_.longPolling=false;
+    }
+  }
+  schedule();
+}
+
+PollScheduler::Entry& PollScheduler::entry(ASIP& session)
+{
+  const auto existing=sessions.find(&session);
+  if (existing!=sessions.end())
+    return existing->second;
+  const auto session_=&session;
+  connect(session_,&QObject::destroyed,this,[this,session_] {
+    sessions.erase(session_);
+  });
+  auto& result=sessions[session_];
+  result.numViews=0;
+  result.waiting=false;
+  result.longPolling=false;
+  result.sinceLastPoll.start();
+  return result;
+}
+
+PollScheduler::Priority PollScheduler::priority(const ASIP& session,const Entry& entry) const
+{
+  if (session.role()!=NO_SIDE && session.getStatus()!=ASIP::FINISHED)
+    return PLAYING;
+  else
+    return entry.numViews>0 ? SHOWN : HIDDEN;
+}
+
+void PollScheduler::schedule()
+{
+  unsigned int numSpectatorLongPolls=0;
+  std::vector<std::pair<Priority,ASIP*> > waiting;
+  for (const auto& session:sessions) {
+    const auto& entry=session.second;
+    if (entry.waiting)
+      waiting.emplace_back(priority(*session.first,entry),session.first);
+    else if (entry.longPolling && priority(*session.first,entry)!=PLAYING)
+      ++numSpectatorLongPolls;
+  }
+  std::stable_sort(waiting.begin(),waiting.end(),[this](const std::pair<Priority,ASIP*>& lhs,const std::pair<Priority,ASIP*>& rhs) {
+    if (lhs.first!=rhs.first)
+      return lhs.first>rhs.first;
+    return sessions[lhs.second].sinceLastPoll.elapsed()>sessions[rhs.second].sinceLastPoll.elapsed();
+  });
+
+  qint64 nextPoll=-1;
+  for (const auto& candidate:waiting) {
+    auto& session=*candidate.second;
+    auto& entry=sessions[&session];
+    bool longPoll;
+    if (candidate.first==PLAYING)
+      longPoll=true;
+    else if (candidate.first==SHOWN && numSpectatorLongPolls<MAX_SPECTATOR_LONG_POLLS) {
+      longPoll=true;
+      ++numSpectatorLongPolls;
+    }
+    else {
+      const auto remaining=(candidate.first==SHOWN ? SHOWN_INTERVAL : HIDDEN_INTERVAL)-entry.sinceLastPoll.elapsed();
+      if (remaining>0) {
+        nextPoll=(nextPoll<0 ? remaining : std::min(nextPoll,remaining));
+        continue;
+      }
+      longPoll=false;
+    }
+    entry.waiting=false;
+    entry.longPolling=longPoll;
+    session.poll(longPoll);
+  }
+  if (nextPoll>=0)
+    timer.start(nextPoll);
+  else
+    timer.stop();
+}
@@ -0,0 +1,44 @@
+#ifndef POLLSCHEDULER_HPP
+#define POLLSCHEDULER_HPP
+
+#include <map>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QUrl>
+class ASIP;
+
+class PollScheduler : public QObject {
+public:
+  static PollScheduler& of(const ASIP& session);
+  void enqueue(ASIP& session);
+  void remove(ASIP& session);
+  void setShown(ASIP& session,const bool shown);
+private:
+  struct Entry {
+    unsigned int numViews;
+    bool waiting;
+    bool longPolling;
+    QElapsedTimer sinceLastPoll;
+  };
+  enum Priority {
+    HIDDEN,
+    SHOWN,
+    PLAYING
+  };
+
+  PollScheduler();
+  Entry& entry(ASIP& session);
+  Priority priority(const ASIP& session,const Entry& entry) const;
+  void schedule();
+
+  static constexpr unsigned int MAX_SPECTATOR_LONG_POLLS=3;
+  static constexpr qint64 SHOWN_INTERVAL=5*1000;
+  static constexpr qint64 HIDDEN_INTERVAL=30*1000;
+
+  std::map<ASIP*,Entry> sessions;
+  QTimer timer;
+
+  static std::map<QUrl,PollScheduler*> schedulers;
+};
+
+#endif // POLLSCHEDULER_HPP
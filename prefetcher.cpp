@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <QNetworkReply>
+#include "prefetcher.hpp"
+#include "asip.hpp"
+
+Prefetcher::Prefetcher(ASIP& session_,QObject* const parent) :
+  QObject(parent),
+  session(session_),
+  sweeper(this)
+{
+  connect(&sweeper,&QTimer::timeout,this,&Prefetcher::sweep);
+}
+
+Prefetcher::~Prefetcher()
+{
+  while (!entries.empty())
+    evict(entries.begin());
+}
+
+void Prefetcher::prefetch(const QString& gameID)
+{
+  const auto existing=entries.find(gameID);
+  if (existing!=entries.end()) {
+    existing->second.age.start();
+    return;
+  }
+  if (entries.size()>=MAX_ENTRIES)
+    evict(std::min_element(entries.begin(),entries.end(),[](const std::pair<const QString,Entry>& lhs,const std::pair<const QString,Entry>& rhs) {
+      return lhs.second.age.elapsed()>rhs.second.age.elapsed();
+    }));
+  auto& entry=entries[gameID];
+  entry.ready=false;
+  entry.reservation=nullptr;
+  entry.age.start();
+  if (!sweeper.isActive())
+    sweeper.start(LIFETIME/2);
+
+  session.enterGame(this,gameID,NO_SIDE,[this,gameID](QNetworkReply* const networkReply) {
+    const auto entry=entries.find(gameID);
+    if (entry!=entries.end())
+      entry->second.reservation=networkReply;
+    connect(networkReply,&QNetworkReply::finished,this,[this,gameID,networkReply] {
+      // A reply for an entry that was evicted and prefetched again belongs to the old entry.
+      auto entry=entries.find(gameID);
+      if (entry!=entries.end() && entry->second.reservation!=networkReply)
+        entry=entries.end();
+      try {
+        auto game=session.getGame(*networkReply);
+        if (entry==entries.end())
+          return;
+        game->sit();
+        connect(game.get(),&ASIP::updated,this,[this,gameID] {
+          const auto entry=entries.find(gameID);
+          if (entry!=entries.end())
+            entry->second.ready=true;
+        });
+        entry->second.game=std::move(game);
+      }
+      catch (const std::exception&) {
+        if (entry!=entries.end())
+          evict(entry);
+      }
+    });
+  });
+}
+
+std::unique_ptr<ASIP> Prefetcher::take(const QString& gameID)
+{
+  const auto entry=entries.find(gameID);
+  if (entry==entries.end() || !entry->second.ready)
+    return nullptr;
+  auto game=std::move(entry->second.game);
+  disconnect(game.get(),&ASIP::updated,this,nullptr);
+  entries.erase(entry);
+  return game;
+}
+
+void Prefetcher::evict(std::map<QString,Entry>::iterator entry)
+{
+  // The game session may be in the middle of emitting a signal.
+  if (entry->second.game!=nullptr)
+    entry->second.game.release()->deleteLater();
+  entries.erase(entry);
+}
+
+void Prefetcher::sweep()
+{
+  for (auto entry=entries.begin();entry!=entries.end();) {
+    if (entry->second.age.elapsed()>=LIFETIME)
+      evict(entry++);
+    else
+      ++entry;
+  }
+  if (entries.empty())
+    sweeper.stop();
+}
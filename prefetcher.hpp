@@ -0,0 +1,36 @@
+#ifndef PREFETCHER_HPP
+#define PREFETCHER_HPP
+
+#include <map>
+#include <memory>
+#include <QTimer>
+#include <QElapsedTimer>
+class ASIP;
+class QNetworkReply;
+
+class Prefetcher : public QObject {
+public:
+  explicit Prefetcher(ASIP& session_,QObject* const parent=nullptr);
+  virtual ~Prefetcher() override;
+  void prefetch(const QString& gameID);
+  std::unique_ptr<ASIP> take(const QString& gameID);
+private:
+  struct Entry {
+    std::unique_ptr<ASIP> game;
+    bool ready;
+    QNetworkReply* reservation;
+    QElapsedTimer age;
+  };
+
+  void evict(std::map<QString,Entry>::iterator entry);
+  void sweep();
+
+  static constexpr qint64 LIFETIME=30*1000;
+  static constexpr unsigned int MAX_ENTRIES=8;
+
+  ASIP& session;
+  std::map<QString,Entry> entries;
+  QTimer sweeper;
+};
+
+#endif // PREFETCHER_HPP
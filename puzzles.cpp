@@ -1,4 +1,5 @@
-#include <fstream>
+#include <map>
+#include <numeric>
 #include <QPainter>
 #include "puzzles.hpp"
 #include "globals.hpp"
@@ -11,6 +12,10 @@ using namespace std;
 Puzzles::Puzzles(Globals& globals_,const std::string& fileName,QWidget* const parent) :
   Game(globals_,FIRST_SIDE,parent,nullptr,make_unique<TurnState>(),1),
   globals(globals_),
+  records(nullptr),
+  numRecords(0),
+  stopValidation(false),
+  puzzleIndex(0),
   pieceType(LAST_PIECE_TYPE),
   keepScore(false),
   reshuffle(tr("&Reshuffle")),
@@ -30,7 +35,7 @@ Puzzles::Puzzles(Globals& globals_,const std::string& fileName,QWidget* const pa
   setWindowTitle(tr("Puzzles (%1)").arg(QString::fromStdString(fileName)));
 
   connect(&reshuffle,&QPushButton::clicked,this,[this] {
-    shuffle(puzzles.begin(),puzzles.end(),globals.rndEngine);
+    shuffle(order.begin(),order.end(),globals.rndEngine);
     try {
       setPuzzle(0);
     }
@@ -149,41 +154,162 @@ Puzzles::Puzzles(Globals& globals_,const std::string& fileName,QWidget* const pa
     MessageBox(QMessageBox::Critical,tr("Error reading puzzle file"),exception.what(),QMessageBox::NoButton,this).exec();
     throw;
   }
-  shuffle(puzzles.begin(),puzzles.end(),globals.rndEngine);
-  try {
-    setPuzzle(0);
-  }
-  catch (...) {
-    throw;
-  }
-  setPuzzleCount();
+  shuffle(order.begin(),order.end(),globals.rndEngine);
+  setPuzzle(0);
   show();
+  validator=std::thread(&Puzzles::validatePuzzles,this);
+}
+
+Puzzles::~Puzzles()
+{
+  stopValidation=true;
+  if (validator.joinable())
+    validator.join();
 }
 
 void Puzzles::setPuzzleCount()
 {
-  spinBox.setRange(DISPLAYED_INDEX_OFFSET,puzzles.size()-1+DISPLAYED_INDEX_OFFSET);
-  dockWidgets[NUM_STANDARD_DOCK_WIDGETS].setWindowTitle(tr("%1 puzzle(s)").arg(QString::number(puzzles.size())));
+  const QSignalBlocker signalBlocker(spinBox);
+  spinBox.setRange(DISPLAYED_INDEX_OFFSET,order.size()-1+DISPLAYED_INDEX_OFFSET);
+  spinBox.setValue(puzzleIndex+DISPLAYED_INDEX_OFFSET);
+  dockWidgets[NUM_STANDARD_DOCK_WIDGETS].setWindowTitle(tr("%1 puzzle(s)").arg(QString::number(order.size())));
 }
 
 void Puzzles::loadPuzzles(const std::string& fileName)
 {
-  std::ifstream is(fileName,std::ios::binary);
-  is.seekg(0,std::ios::end);
-  runtime_assert(is.tellg()%PUZZLE_BYTE_SIZE==0,"File size is not a multiple of "+QString::number(PUZZLE_BYTE_SIZE)+" bytes.");
-  is.seekg(0);
-  PuzzleData puzzle;
-  while (true) {
-    is.read(reinterpret_cast<char*>(puzzle.data()),puzzle.size());
-    const auto gcount=is.gcount();
-    if (gcount==PUZZLE_BYTE_SIZE)
-      puzzles.emplace_back(puzzle);
-    else {
-      assert(gcount==0);
-      break;
+  file.setFileName(QString::fromStdString(fileName));
+  records=mapPuzzles(file,numRecords);
+  order.resize(numRecords);
+  iota(order.begin(),order.end(),0);
+}
+
+const uchar* Puzzles::mapPuzzles(QFile& file,quint32& numRecords)
+{
+  runtime_assert(file.isOpen() || file.open(QIODevice::ReadOnly),file.errorString());
+  const auto size=file.size();
+  runtime_assert(size%PUZZLE_BYTE_SIZE==0,"File size is not a multiple of "+QString::number(PUZZLE_BYTE_SIZE)+" bytes.");
+  runtime_assert(size>0,"File is empty.");
+  runtime_assert(size/PUZZLE_BYTE_SIZE<=std::numeric_limits<quint32>::max(),"File has too many puzzles.");
+  const auto result=file.map(0,size);
+  runtime_assert(result!=nullptr,file.errorString());
+  numRecords=size/PUZZLE_BYTE_SIZE;
+  return result;
+}
+
+Puzzles::PuzzleData Puzzles::record(const quint32 recordIndex) const
+{
+  assert(recordIndex<numRecords);
+  return record(records,recordIndex);
+}
+
+Puzzles::PuzzleData Puzzles::record(const uchar* const records,const quint32 recordIndex)
+{
+  PuzzleData result;
+  const auto begin=records+size_t(recordIndex)*PUZZLE_BYTE_SIZE;
+  copy(begin,begin+PUZZLE_BYTE_SIZE,result.begin());
+  return result;
+}
+
+void Puzzles::validatePuzzles()
+{
+  std::vector<std::pair<quint32,QString> > invalidRecords;
+  for (quint32 recordIndex=0;recordIndex<numRecords && !stopValidation;++recordIndex) {
+    try {
+      validate(record(recordIndex));
     }
+    catch (const std::exception& exception) {
+      invalidRecords.emplace_back(recordIndex,exception.what());
+    }
+  }
+  if (!stopValidation && !invalidRecords.empty())
+    QMetaObject::invokeMethod(this,[this,invalidRecords]{removeRecords(invalidRecords);},Qt::QueuedConnection);
+}
+
+void Puzzles::removeRecords(const std::vector<std::pair<quint32,QString> >& invalidRecords)
+{
+  if (order.empty())
+    return;
+  std::vector<bool> invalid(numRecords,false);
+  QString details;
+  for (const auto& invalidRecord:invalidRecords) {
+    invalid[invalidRecord.first]=true;
+    details+=tr("Record %1: %2").arg(invalidRecord.first+DISPLAYED_INDEX_OFFSET).arg(invalidRecord.second)+'\n';
+  }
+  const auto currentRecord=(puzzleIndex<order.size() ? order[puzzleIndex] : order.front());
+  order.erase(remove_if(order.begin(),order.end(),[&invalid](const quint32 recordIndex){return invalid[recordIndex];}),order.end());
+
+  MessageBox messageBox(QMessageBox::Warning,tr("Error parsing puzzle data"),tr("%1 of %2 puzzle(s) could not be read and will be skipped.").arg(invalidRecords.size()).arg(numRecords),QMessageBox::NoButton,this);
+  messageBox.setDetailedText(details);
+  if (order.empty()) {
+    messageBox.setText(messageBox.text()+"\n\n"+tr("No more data."));
+    messageBox.exec();
+    close();
+    return;
+  }
+  const auto current=find(order.begin(),order.end(),currentRecord);
+  if (current==order.end())
+    setPuzzle(0);
+  else {
+    puzzleIndex=distance(order.begin(),current);
+    setPuzzleCount();
+  }
+  messageBox.exec();
+}
+
+void Puzzles::validate(const PuzzleData& puzzleData)
+{
+  const auto puzzle=toPuzzle(puzzleData);
+  const Node node(nullptr,ExtendedSteps(),GameState(puzzle.first));
+  runtime_assert(node.legalMove(puzzle.first.toExtendedSteps(puzzle.second))==MoveLegality::LEGAL,"Illegal solution move.");
+}
+
+int Puzzles::checkFile(const QString& fileName,QTextStream& output)
+{
+  QFile file(fileName);
+  quint32 numRecords;
+  const auto records=mapPuzzles(file,numRecords);
+
+  std::vector<QString> errors(numRecords);
+  std::vector<size_t> numSolutions(numRecords,0);
+  std::vector<TurnState::Hash> hashes(numRecords);
+  std::atomic<quint32> nextIndex(0);
+  Solver::runParallel(Solver::defaultNumThreads(),[&] {
+    for (quint32 recordIndex;(recordIndex=nextIndex++)<numRecords;) {
+      try {
+        const auto puzzleData=record(records,recordIndex);
+        validate(puzzleData);
+        const auto puzzle=toPuzzle(puzzleData);
+        hashes[recordIndex]=puzzle.first.canonicalHash();
+        const auto node=make_shared<Node>(nullptr,ExtendedSteps(),GameState(puzzle.first));
+        numSolutions[recordIndex]=Solver(node,puzzle.first.toExtendedSteps(puzzle.second)).solutions(1).size();
+      }
+      catch (const std::exception& exception) {
+        errors[recordIndex]=exception.what();
+      }
+    }
+  });
+
+  quint32 numUnique=0,numInvalid=0,numDuplicates=0;
+  std::map<TurnState::Hash,quint32> firstOccurrences;
+  for (quint32 recordIndex=0;recordIndex<numRecords;++recordIndex) {
+    const auto displayedIndex=recordIndex+DISPLAYED_INDEX_OFFSET;
+    if (!errors[recordIndex].isEmpty()) {
+      output<<tr("Record %1: %2").arg(displayedIndex).arg(errors[recordIndex])<<'\n';
+      ++numInvalid;
+      continue;
+    }
+    const auto firstOccurrence=firstOccurrences.emplace(hashes[recordIndex],recordIndex).first->second;
+    if (firstOccurrence!=recordIndex) {
+      output<<tr("Record %1: equivalent to record %2").arg(displayedIndex).arg(firstOccurrence+DISPLAYED_INDEX_OFFSET)<<'\n';
+      ++numDuplicates;
+    }
+    if (numSolutions[recordIndex]==1)
+      ++numUnique;
+    else
+      output<<tr("Record %1: %2 solutions").arg(displayedIndex).arg(numSolutions[recordIndex])<<'\n';
   }
-  runtime_assert(!puzzles.empty(),"File is empty.");
+  output<<tr("%1 puzzle(s): %2 unique, %3 ambiguous, %4 invalid, %5 duplicate").arg(numRecords).arg(numUnique).arg(numRecords-numUnique-numInvalid).arg(numInvalid).arg(numDuplicates)<<'\n';
+  return numUnique==numRecords && numDuplicates==0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 Puzzles::Puzzle Puzzles::toPuzzle(const PuzzleData& puzzleData)
@@ -352,7 +478,7 @@ void Puzzles::randomize(Puzzle& puzzle) const
   if (globals.rand(2)!=0)
     mirror(puzzle);
   auto& state=puzzle.first;
-  const auto remappings=TurnState::typeRemappings(state.pieceCounts());
+  const auto& remappings=TurnState::cachedTypeRemappings(state.pieceCounts());
   state.remapPieces(remappings[globals.rand(remappings.size())]);
 }
 
@@ -360,26 +486,23 @@ void Puzzles::setPuzzle(unsigned int newIndex)
 {
   while (true) {
     try {
-      assert(newIndex<puzzles.size());
-      setPuzzle(toPuzzle(puzzles[newIndex]));
+      assert(newIndex<order.size());
+      setPuzzle(toPuzzle(record(order[newIndex])));
       break;
     }
     catch (const std::exception& exception) {
-      puzzles.erase(puzzles.begin()+newIndex);
-      setPuzzleCount();
-      if (newIndex>=puzzles.size()) {
+      order.erase(order.begin()+newIndex);
+      if (newIndex>=order.size()) {
+        puzzleIndex=0;
+        if (!order.empty())
+          setPuzzleCount();
         MessageBox(QMessageBox::Critical,tr("Error parsing puzzle data"),QString(exception.what())+"\n\n"+tr("No more data."),QMessageBox::NoButton,this).exec();
         throw;
       }
-      else {
-        MessageBox messageBox(QMessageBox::Question,tr("Error parsing puzzle data"),QString(exception.what())+"\n\n"+tr("Try next chunk?"),QMessageBox::Yes|QMessageBox::No,this);
-        if (messageBox.exec()==QMessageBox::No)
-          throw;
-      }
     }
   }
   puzzleIndex=newIndex;
-  spinBox.setValue(puzzleIndex+DISPLAYED_INDEX_OFFSET);
+  setPuzzleCount();
 }
 
 void Puzzles::setPuzzle(Puzzle puzzle)
@@ -404,6 +527,7 @@ void Puzzles::setPuzzle(const NodePtr node,const ExtendedSteps& newSolution)
   board.setControllable({state.sideToMove==FIRST_SIDE,state.sideToMove==SECOND_SIDE});
 
   solution=newSolution;
+  solver=make_unique<Solver>(node,solution);
   differentSquares=TurnState::differentSquares(state.squarePieces,resultingState(solution).squarePieces);
   assert(!differentSquares.empty());
   clearHints();
@@ -432,7 +556,7 @@ void Puzzles::receiveNodeChange(const NodePtr& newNode)
   else {
     Node::addToTree(gameTree,newNode);
     emit treeModel.layoutChanged();
-    if (newNode->gameState.squarePieces==resultingState(solution).squarePieces) {
+    if (solver->achievesGoal(newNode->move)) {
       const auto elapsed=solveTimer.elapsed();
       if (solveTimer.isValid()) {
         if (sounds.isChecked())
@@ -444,7 +568,7 @@ void Puzzles::receiveNodeChange(const NodePtr& newNode)
       evaluation.setText("RIGHT");
       keepScore=true;
       bool puzzleChanged=false;
-      if (autoAdvance.isChecked() && puzzleIndex+1<puzzles.size()) {
+      if (autoAdvance.isChecked() && puzzleIndex+1<order.size()) {
         try {
           setPuzzle(puzzleIndex+1);
           puzzleChanged=true;
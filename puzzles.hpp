@@ -1,31 +1,46 @@
 #ifndef PUZZLES_HPP
 #define PUZZLES_HPP
 
-#include <deque>
+#include <thread>
+#include <atomic>
+#include <QFile>
 #include <QElapsedTimer>
 #include <QSpinBox>
+#include <QTextStream>
 #include "game.hpp"
+#include "solver.hpp"
 
 class Puzzles : public Game {
 public:
   Puzzles(Globals& globals_,const std::string& fileName,QWidget* const parent);
+  ~Puzzles();
 private:
   static constexpr auto SQUARE_BIT_SIZE=4;
   static constexpr auto SQUARE_DATA_RANGE=1<<SQUARE_BIT_SIZE;
   static constexpr auto SQUARES_PER_BYTES=CHAR_BIT/SQUARE_BIT_SIZE;
   static constexpr auto BYTES_PER_BOARD=roundedUpDivision(int(NUM_SQUARES),SQUARES_PER_BYTES);
+public:
   static constexpr auto PUZZLE_BYTE_SIZE=BYTES_PER_BOARD+MAX_STEPS_PER_MOVE;
-  static constexpr unsigned char EMPTY_VALUE=SQUARE_DATA_RANGE-1;
-  static constexpr unsigned char PASS=0;
-  static constexpr auto DISPLAYED_INDEX_OFFSET=1;
 
   typedef std::array<unsigned char,PUZZLE_BYTE_SIZE> PuzzleData;
   typedef std::pair<TurnState,Steps> Puzzle;
 
-  void setPuzzleCount();
-  void loadPuzzles(const std::string& fileName);
+  static const uchar* mapPuzzles(QFile& file,quint32& numRecords);
+  static PuzzleData record(const uchar* const records,const quint32 recordIndex);
+  static void validate(const PuzzleData& puzzleData);
   static Puzzle toPuzzle(const PuzzleData& puzzleData);
   static PuzzleData toData(Puzzle puzzle);
+  static int checkFile(const QString& fileName,QTextStream& output);
+private:
+  static constexpr unsigned char EMPTY_VALUE=SQUARE_DATA_RANGE-1;
+  static constexpr unsigned char PASS=0;
+  static constexpr auto DISPLAYED_INDEX_OFFSET=1;
+
+  void setPuzzleCount();
+  void loadPuzzles(const std::string& fileName);
+  PuzzleData record(const quint32 recordIndex) const;
+  void validatePuzzles();
+  void removeRecords(const std::vector<std::pair<quint32,QString> >& invalidRecords);
   static PieceTypeAndSide toSquareValue(const unsigned char bits);
   static unsigned char toData(const PieceTypeAndSide squareValue);
   static Step toStep(const unsigned char byte,const bool strict=true);
@@ -43,9 +58,15 @@ private:
 
   static const std::vector<SquareIndex> trapSquares;
   Globals& globals;
-  std::deque<PuzzleData> puzzles;
+  QFile file;
+  const uchar* records;
+  quint32 numRecords;
+  std::vector<quint32> order;
+  std::thread validator;
+  std::atomic<bool> stopValidation;
   unsigned int puzzleIndex;
   ExtendedSteps solution;
+  std::unique_ptr<Solver> solver;
   std::vector<SquareIndex> differentSquares;
   std::vector<SquareIndex>::iterator pastRevealed;
   PieceType pieceType;
@@ -15,9 +15,13 @@ Server::Server(Globals& globals_,ASIP& session_,MainWindow& mainWindow_) :
   vBoxLayout(this),
   newGame(tr("&Create open game")),
   openGame(tr("&Open existing game")),
-  refresh(tr("&Refresh page"))
+  refresh(tr("&Refresh page")),
+  prefetcher(session_,this),
+  refreshTimer(this)
 {
   session.setParent(this);
+  refreshTimer.setSingleShot(true);
+  connect(&refreshTimer,&QTimer::timeout,&session,&ASIP::state);
 
   const QString gameListCategoryTitles[]={tr("My games"),tr("Invited games"),tr("Open games"),tr("Live games"),tr("Recent games")};
   for (const auto gameListCategory:session.availableGameListCategories()) {
@@ -63,11 +67,27 @@ Server::~Server()
 
 void Server::refreshPage() const
 {
-  session.state();
+  // Requests from several game lists and games in quick succession are served by a single refresh.
+  if (!refreshTimer.isActive())
+    refreshTimer.start(REFRESH_DELAY);
+}
+
+void Server::prefetch(const ASIP::GameInfo& game)
+{
+  const auto& self=session.username();
+  for (const auto& player:game.players)
+    if (player.isEmpty() || player==self)
+      return;
+  prefetcher.prefetch(game.id);
 }
 
 void Server::enterGame(const ASIP::GameInfo& game,const Side role,const Side viewpoint)
 {
+  if (role==NO_SIDE)
+    if (auto prefetchedGame=prefetcher.take(game.id)) {
+      mainWindow.addGame(std::move(prefetchedGame),viewpoint,false);
+      return;
+    }
   session.enterGame(this,game.id,role,[=](QNetworkReply* const networkReply) {
     connect(networkReply,&QNetworkReply::finished,this,[=] {
       try {
@@ -91,9 +111,9 @@ void Server::addGame(QNetworkReply& networkReply,const Side viewpoint,const bool
 void Server::resizeEvent(QResizeEvent*)
 {
   for (const auto& gameList:gameLists) {
-    gameList.second.get()->tableWidget.horizontalHeader()->setStretchLastSection(false);
-    gameList.second.get()->tableWidget.horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
-    gameList.second.get()->tableWidget.horizontalHeader()->setStretchLastSection(true);
-    gameList.second.get()->tableWidget.horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    gameList.second.get()->tableView.horizontalHeader()->setStretchLastSection(false);
+    gameList.second.get()->tableView.horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    gameList.second.get()->tableView.horizontalHeader()->setStretchLastSection(true);
+    gameList.second.get()->tableView.horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
   }
 }
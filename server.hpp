@@ -4,7 +4,9 @@
 #include <memory>
 #include <QVBoxLayout>
 #include <QPushButton>
+#include <QTimer>
 #include "asip.hpp"
+#include "prefetcher.hpp"
 struct Globals;
 class MainWindow;
 class GameList;
@@ -15,6 +17,7 @@ public:
   explicit Server(Globals& globals_,ASIP& session_,MainWindow& mainWindow_);
   virtual ~Server() override;
   void refreshPage() const;
+  void prefetch(const ASIP::GameInfo& game);
   void enterGame(const ASIP::GameInfo& game,const Side role,const Side viewpoint);
   void addGame(QNetworkReply& networkReply,const Side viewpoint,const bool guaranteedUnique=false) const;
 
@@ -30,6 +33,10 @@ private:
       QPushButton newGame,openGame,refresh;
 
   std::map<ASIP::GameListCategory,std::unique_ptr<GameList> > gameLists;
+  Prefetcher prefetcher;
+  mutable QTimer refreshTimer;
+
+  static constexpr int REFRESH_DELAY=100;
 };
 
 #endif // SERVER_HPP
@@ -0,0 +1,206 @@
+#include <QCoreApplication>
+#include <QNetworkAccessManager>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <QTextStream>
+#include "sessionlog.hpp"
+#include "mainwindow.hpp"
+#include "globals.hpp"
+#include "login.hpp"
+#include "asip.hpp"
+#include "io.hpp"
+
+SessionLog* SessionLog::instance=nullptr;
+
+SessionLog::SessionLog(const QString& fileName,const double speed_,MainWindow* const mainWindow_) :
+  QObject(QCoreApplication::instance()),
+  file(fileName),
+  speed(speed_),
+  mainWindow(mainWindow_),
+  numRequests(0)
+{
+  clock.start();
+}
+
+SessionLog* SessionLog::current()
+{
+  return instance;
+}
+
+void SessionLog::record(const QString& fileName)
+{
+  std::unique_ptr<SessionLog> sessionLog(new SessionLog(fileName,1,nullptr));
+  runtime_assert(sessionLog->file.open(QIODevice::WriteOnly|QIODevice::Text),sessionLog->file.errorString());
+  instance=sessionLog.release();
+}
+
+void SessionLog::replay(const QString& fileName,const double speed,MainWindow& mainWindow)
+{
+  std::unique_ptr<SessionLog> sessionLog(new SessionLog(fileName,speed,&mainWindow));
+  sessionLog->load();
+  instance=sessionLog.release();
+}
+
+QNetworkReply* SessionLog::post(const QUrl& url,const std::vector<std::pair<QString,QString> >& items)
+{
+  QHash<QString,QString> hash;
+  for (const auto& item:items)
+    hash.insert(item.first,item.second);
+  auto& queue=exchanges[matchKey(url,hash)];
+  if (queue.empty())
+    return new ReplayReply(url,QByteArray(),-1,this);
+  const auto exchange=queue.front();
+  queue.pop_front();
+  return new ReplayReply(url,exchange.reply,static_cast<qint64>(exchange.delay/speed),this);
+}
+
+void SessionLog::logRequest(const ASIP& session,QNetworkReply& networkReply,const std::vector<std::pair<QString,QString> >& items)
+{
+  if (replaying())
+    return;
+  const auto serial=++numRequests;
+  networkReply.setProperty("log_serial",serial);
+  QJsonObject object;
+  for (const auto& item:items)
+    object.insert(item.first,item.first=="password" ? QString() : item.second);
+  const QStringList fields{"post",QString::number(serial),QString::number(clock.elapsed()),session.metaObject()->className(),
+                           networkReply.url().toString(),QString::fromUtf8(QJsonDocument(object).toJson(QJsonDocument::Compact))};
+  file.write((fields.join('\t')+'\n').toUtf8());
+  file.flush();
+}
+
+void SessionLog::logReply(const QNetworkReply& networkReply,const QByteArray& data)
+{
+  const auto serial=networkReply.property("log_serial");
+  if (replaying() || !serial.isValid())
+    return;
+  const QStringList fields{"reply",serial.toString(),QString::number(clock.elapsed()),QString::fromLatin1(data.toBase64())};
+  file.write((fields.join('\t')+'\n').toUtf8());
+  file.flush();
+}
+
+void SessionLog::load()
+{
+  runtime_assert(file.open(QIODevice::ReadOnly|QIODevice::Text),file.errorString());
+  std::map<unsigned long long,Exchange> recorded;
+  while (!file.atEnd()) {
+    const auto fields=QString::fromUtf8(file.readLine()).trimmed().split('\t');
+    if (fields.size()==6 && fields[0]=="post") {
+      Exchange exchange;
+      exchange.postTime=fields[2].toLongLong();
+      exchange.delay=-1;
+      exchange.sessionClass=fields[3];
+      exchange.url=QUrl(fields[4]);
+      const auto object=QJsonDocument::fromJson(fields[5].toUtf8()).object();
+      for (auto item=object.begin();item!=object.end();++item)
+        exchange.items.insert(item.key(),item.value().toString());
+      recorded[fields[1].toULongLong()]=exchange;
+    }
+    else if (fields.size()==4 && fields[0]=="reply") {
+      const auto exchange=recorded.find(fields[1].toULongLong());
+      if (exchange!=recorded.end()) {
+        exchange->second.delay=fields[2].toLongLong()-exchange->second.postTime;
+        exchange->second.reply=QByteArray::fromBase64(fields[3].toLatin1());
+      }
+    }
+    else
+      runtime_assert(fields.size()==1 && fields[0].isEmpty(),"Invalid session log entry.");
+  }
+  runtime_assert(!recorded.empty(),"Session log is empty.");
+
+  // Requests that were aborted before their reply arrived are left out, so that replies line up with the requests that got them.
+  for (const auto& entry:recorded) {
+    const auto& exchange=entry.second;
+    if (exchange.delay<0)
+      continue;
+    exchanges[matchKey(exchange.url,exchange.items)].push_back(exchange);
+    const auto action=exchange.items.value("action");
+    if (action=="login" || action=="newgame" || action=="reserveseat")
+      QTimer::singleShot(static_cast<int>(exchange.postTime/speed),this,[this,exchange]{drive(exchange);});
+  }
+}
+
+void SessionLog::drive(const Exchange& exchange)
+{
+  const auto action=exchange.items.value("action");
+  if (action=="login") {
+    const auto session=Login::newSession(mainWindow->globals.networkAccessManager,exchange.url.toString(),exchange.sessionClass=="ASIP1" ? 1 : 2,this);
+    const auto networkReply=session->login(this,exchange.items.value("username"),QString());
+    connect(networkReply,&QNetworkReply::finished,this,[this,session,networkReply] {
+      try {
+        session->processReply(*networkReply);
+        sessions[session->currentState()->sid]=session;
+        mainWindow->addServer(*session);
+      }
+      catch (const std::exception& exception) {
+        session->deleteLater();
+        QTextStream(stderr)<<exception.what()<<'\n';
+      }
+    });
+  }
+  else {
+    const auto session=sessions.find(exchange.items.value("sid"));
+    if (session==sessions.end())
+      return;
+    const auto asip=session->second;
+    const auto role=exchange.items.value("role");
+    const Side side=(role.isEmpty() ? NO_SIDE : toSide(role[0].toLatin1()));
+    const auto addGame=[this,asip,side](QNetworkReply* const networkReply) {
+      connect(networkReply,&QNetworkReply::finished,this,[this,asip,side,networkReply] {
+        try {
+          mainWindow->addGame(asip->getGame(*networkReply),side==NO_SIDE ? FIRST_SIDE : side,true);
+        }
+        catch (const std::exception& exception) {
+          QTextStream(stderr)<<exception.what()<<'\n';
+        }
+      });
+    };
+    if (action=="newgame")
+      addGame(asip->createGame(this,exchange.items.value("timecontrol"),exchange.items.value("rated")=="1",side));
+    else
+      asip->enterGame(this,exchange.items.value("gid"),side,addGame);
+  }
+}
+
+QString SessionLog::matchKey(const QUrl& url,const QHash<QString,QString>& items)
+{
+  QStringList result{url.toString()};
+  for (const auto key:{"action","sid","gid","tid","grid","username"})
+    result.append(items.value(key));
+  return result.join('\t');
+}
+
+SessionLog::ReplayReply::ReplayReply(const QUrl& url,const QByteArray& data_,const qint64 delay,QObject* const parent) :
+  QNetworkReply(parent),
+  data(data_),
+  offset(0)
+{
+  setUrl(url);
+  setOperation(QNetworkAccessManager::PostOperation);
+  open(QIODevice::ReadOnly);
+  if (delay>=0)
+    QTimer::singleShot(static_cast<int>(delay),this,[this] {
+      setFinished(true);
+      emit readyRead();
+      emit finished();
+    });
+}
+
+void SessionLog::ReplayReply::abort()
+{
+  close();
+}
+
+qint64 SessionLog::ReplayReply::bytesAvailable() const
+{
+  return data.size()-offset+QNetworkReply::bytesAvailable();
+}
+
+qint64 SessionLog::ReplayReply::readData(char* const buffer,const qint64 maxSize)
+{
+  const auto size=std::min<qint64>(maxSize,data.size()-offset);
+  std::copy(data.constData()+offset,data.constData()+offset+size,buffer);
+  offset+=size;
+  return size;
+}
@@ -0,0 +1,59 @@
+#ifndef SESSIONLOG_HPP
+#define SESSIONLOG_HPP
+
+#include <map>
+#include <deque>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QNetworkReply>
+class MainWindow;
+class ASIP;
+
+class SessionLog : public QObject {
+public:
+  static SessionLog* current();
+  static void record(const QString& fileName);
+  static void replay(const QString& fileName,const double speed,MainWindow& mainWindow);
+
+  bool replaying() const {return mainWindow!=nullptr;}
+  QNetworkReply* post(const QUrl& url,const std::vector<std::pair<QString,QString> >& items);
+  void logRequest(const ASIP& session,QNetworkReply& networkReply,const std::vector<std::pair<QString,QString> >& items);
+  void logReply(const QNetworkReply& networkReply,const QByteArray& data);
+private:
+  struct Exchange {
+    qint64 postTime,delay;
+    QString sessionClass;
+    QUrl url;
+    QHash<QString,QString> items;
+    QByteArray reply;
+  };
+  class ReplayReply : public QNetworkReply {
+  public:
+    ReplayReply(const QUrl& url,const QByteArray& data_,const qint64 delay,QObject* const parent);
+    virtual void abort() override;
+    virtual qint64 bytesAvailable() const override;
+    virtual bool isSequential() const override {return true;}
+  protected:
+    virtual qint64 readData(char* const buffer,const qint64 maxSize) override;
+  private:
+    const QByteArray data;
+    qint64 offset;
+  };
+
+  SessionLog(const QString& fileName,const double speed_,MainWindow* const mainWindow_);
+  void load();
+  void drive(const Exchange& exchange);
+  static QString matchKey(const QUrl& url,const QHash<QString,QString>& items);
+
+  QFile file;
+  const double speed;
+  MainWindow* const mainWindow;
+  QElapsedTimer clock;
+  unsigned long long numRequests;
+  std::map<QString,std::deque<Exchange> > exchanges;
+  std::map<QString,ASIP*> sessions;
+
+  static SessionLog* instance;
+};
+
+#endif // SESSIONLOG_HPP
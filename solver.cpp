@@ -0,0 +1,70 @@
+#include <map>
+#include <atomic>
+#include "solver.hpp"
+
+Solver::Solver(NodePtr node_,const ExtendedSteps& solution) :
+  node(std::move(node_)),
+  winning(result(node,solution).winner==node->gameState.sideToMove),
+  solutionState(resultingState(solution)),
+  capturing(solutionState.pieceCounts()!=node->gameState.pieceCounts())
+{
+}
+
+bool Solver::achievesGoal(const ExtendedSteps& move) const
+{
+  if (move.empty() || node->legalMove(move)!=MoveLegality::LEGAL)
+    return false;
+  const auto winner=result(node,move).winner;
+  if (winner==node->gameState.sideToMove)
+    return true;
+  else if (winning || winner!=NO_SIDE)
+    return false;
+  // Any capture of the same pieces will do, but quiet puzzles need the exact position.
+  const auto newState=resultingState(move);
+  if (capturing)
+    return newState.pieceCounts()==solutionState.pieceCounts();
+  else
+    return newState.squarePieces==solutionState.squarePieces;
+}
+
+std::vector<ExtendedSteps> Solver::solutions(const unsigned int numThreads) const
+{
+  const auto& gameState=node->gameState;
+  std::vector<ExtendedSteps> firstSteps;
+  for (SquareIndex origin=FIRST_SQUARE;origin<NUM_SQUARES;increment(origin))
+    for (const SquareIndex adjacentSquare:adjacentSquares(origin))
+      if (gameState.legalStep(origin,adjacentSquare)) {
+        GameState changedState(gameState);
+        firstSteps.emplace_back(1,changedState.takeExtendedStep(origin,adjacentSquare));
+      }
+
+  std::atomic<size_t> nextIndex(0);
+  std::mutex mutex;
+  std::map<GameState::Board,ExtendedSteps> solutions;
+  runParallel(std::min<size_t>(numThreads,firstSteps.size()),[&] {
+    for (size_t index;(index=nextIndex++)<firstSteps.size();)
+      for (const auto& move:node->legalMoves(firstSteps[index]))
+        if (achievesGoal(move)) {
+          const std::lock_guard<std::mutex> lock(mutex);
+          solutions.emplace(resultingState(move).squarePieces,move);
+        }
+  });
+
+  std::vector<ExtendedSteps> result;
+  result.reserve(solutions.size());
+  for (const auto& solution:solutions)
+    result.emplace_back(solution.second);
+  return result;
+}
+
+unsigned int Solver::defaultNumThreads()
+{
+  return std::max(1u,std::thread::hardware_concurrency());
+}
+
+Result Solver::result(const NodePtr& node,const ExtendedSteps& move)
+{
+  GameState gameState(resultingState(move));
+  gameState.switchTurn();
+  return Node(node,move,gameState).result;
+}
@@ -0,0 +1,32 @@
+#ifndef SOLVER_HPP
+#define SOLVER_HPP
+
+#include <thread>
+#include "node.hpp"
+
+class Solver {
+public:
+  explicit Solver(NodePtr node_,const ExtendedSteps& solution);
+  bool achievesGoal(const ExtendedSteps& move) const;
+  std::vector<ExtendedSteps> solutions(const unsigned int numThreads=defaultNumThreads()) const;
+  static unsigned int defaultNumThreads();
+  static Result result(const NodePtr& node,const ExtendedSteps& move);
+
+  template<class Function>
+  static void runParallel(const unsigned int numThreads,Function function)
+  {
+    std::vector<std::thread> threads;
+    for (unsigned int threadIndex=1;threadIndex<numThreads;++threadIndex)
+      threads.emplace_back(function);
+    function();
+    for (auto& thread:threads)
+      thread.join();
+  }
+private:
+  const NodePtr node;
+  const bool winning;
+  const GameState solutionState;
+  const bool capturing;
+};
+
+#endif // SOLVER_HPP
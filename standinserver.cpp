@@ -0,0 +1,528 @@
+#include <algorithm>
+#include <QCoreApplication>
+#include <QUrlQuery>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDateTime>
+#include "standinserver.hpp"
+#include "io.hpp"
+
+StandInServer::StandInServer(const QString& timeControl,const int botDelay_,QObject* const parent) :
+  QObject(parent),
+  tcpServer(this),
+  defaultTimeControl(timeControl),
+  defaultTimeLimits(Tournament::TimeLimits::parse(timeControl)),
+  botDelay(botDelay_),
+  generator(std::random_device()()),
+  numIDs(0),
+  numRequests(0)
+{
+  connect(&tcpServer,&QTcpServer::newConnection,this,[this] {
+    while (const auto socket=tcpServer.nextPendingConnection()) {
+      connect(socket,&QTcpSocket::readyRead,this,[this,socket]{receive(*socket);});
+      connect(socket,&QTcpSocket::disconnected,this,[this,socket] {
+        buffers.erase(socket);
+        socket->deleteLater();
+      });
+    }
+  });
+  ensureOpenGames();
+}
+
+quint16 StandInServer::listen(const quint16 port)
+{
+  runtime_assert(tcpServer.listen(QHostAddress::LocalHost,port),tcpServer.errorString());
+  return tcpServer.serverPort();
+}
+
+QString StandInServer::gameroomURL(const int protocol) const
+{
+  return QString("http://127.0.0.1:%1/client%2gr.cgi").arg(tcpServer.serverPort()).arg(protocol);
+}
+
+QString StandInServer::addBotGame()
+{
+  auto& game=newGame(defaultTimeControl,false);
+  for (Side side=FIRST_SIDE;side<NUM_SIDES;increment(side)) {
+    game.players[side]=QString("RandomBot")+toLetter(side);
+    game.bots[side]=true;
+  }
+  startGame(game);
+  return game.id;
+}
+
+int StandInServer::run(const quint16 port,const QString& timeControl,const unsigned int numBotGames,const int botDelay,QTextStream& log)
+{
+  StandInServer server(timeControl,botDelay);
+  server.listen(port);
+  for (unsigned int gameIndex=0;gameIndex<numBotGames;++gameIndex)
+    server.addBotGame();
+  for (int protocol=1;protocol<=2;++protocol)
+    log<<QCoreApplication::translate("StandInServer","ASIP %1.0 game room: %2").arg(protocol).arg(server.gameroomURL(protocol))<<'\n';
+  log.flush();
+  return QCoreApplication::exec();
+}
+
+void StandInServer::receive(QTcpSocket& socket)
+{
+  auto& buffer=buffers[&socket];
+  buffer+=socket.readAll();
+  while (true) {
+    const auto headerEnd=buffer.indexOf("\r\n\r\n");
+    if (headerEnd<0)
+      return;
+    const auto lines=buffer.left(headerEnd).split('\n');
+    int contentLength=0;
+    for (const auto& line:lines)
+      if (line.toLower().startsWith("content-length:"))
+        contentLength=line.mid(line.indexOf(':')+1).trimmed().toInt();
+    const auto bodyStart=headerEnd+4;
+    if (buffer.size()<bodyStart+contentLength)
+      return;
+    const auto path=lines.front().split(' ').value(1);
+    const int protocol=(path.contains("client1g") ? 1 : 2);
+    const auto body=buffer.mid(bodyStart,contentLength);
+    buffer.remove(0,bodyStart+contentLength);
+    handle({&socket,protocol,decode(body,protocol),++numRequests});
+  }
+}
+
+void StandInServer::handle(Request request)
+{
+  const auto action=request.items.value("action");
+  Data data;
+  try {
+    if (action=="sit" || action=="gamestate" || action=="updategamestate" || action=="move" || action=="resign" ||
+        action=="chat" || action=="startgame" || action=="leave" || action=="takeback" || action=="takebackreply") {
+      if (action=="updategamestate" && request.items.value("wait")=="1") {
+        const auto session=sessions.find(request.items.value("sid"));
+        if (session!=sessions.end()) {
+          const auto game=games.find(session->second.gameID);
+          if (game!=games.end() && request.items.value("lastchange")==QString::number(game->second->lastChange)) {
+            auto& waiting=game->second->waiting;
+            waiting.emplace_back(request);
+            const auto game_=game->second;
+            const auto serial=request.serial;
+            QTimer::singleShot(MAX_WAIT,game_,[this,game_,serial] {
+              auto& waiting=game_->waiting;
+              const auto expired=std::find_if(waiting.begin(),waiting.end(),[serial](const Request& request){return request.serial==serial;});
+              if (expired!=waiting.end()) {
+                const auto request=*expired;
+                waiting.erase(expired);
+                respond(*game_,request);
+              }
+            });
+            return;
+          }
+        }
+      }
+      data=gameAction(action,request);
+    }
+    else
+      data=gameroomAction(action,request);
+  }
+  catch (const std::exception& exception) {
+    data={{"error",exception.what()}};
+  }
+  reply(request,data);
+}
+
+StandInServer::Data StandInServer::gameroomAction(const QString& action,const Request& request)
+{
+  const auto& items=request.items;
+  if (action=="login") {
+    const auto username=items.value("username");
+    runtime_assert(!username.isEmpty(),"Username required.");
+    const auto sid=newID();
+    sessions[sid]={username,QString(),QString(),NO_SIDE};
+    return {{"sid",sid}};
+  }
+  const auto session=sessions.find(items.value("sid"));
+  runtime_assert(session!=sessions.end() && session->second.gameID.isEmpty(),"Invalid session ID.");
+  const auto username=session->second.username;
+  if (action=="logout") {
+    sessions.erase(session);
+    return Data();
+  }
+  else if (action=="newgame")
+    return reserveSeat(newGame(items.value("timecontrol"),items.value("rated")=="1"),username,items.value("role"),request.protocol);
+  else if (action=="reserveseat" || action=="cancelopengame") {
+    const auto game=games.find(items.value("gid"));
+    runtime_assert(game!=games.end(),"No such game.");
+    if (action=="reserveseat")
+      return reserveSeat(*game->second,username,items.value("role"),request.protocol);
+    const auto& players=game->second->players;
+    runtime_assert(!game->second->started && std::find(players.begin(),players.end(),username)!=players.end(),"Cannot cancel this game.");
+    for (const auto& waiting:game->second->waiting)
+      reply(waiting,{{"error","Game was cancelled."}});
+    game->second->deleteLater();
+    games.erase(game);
+    return Data();
+  }
+  else if (action=="mygames" || action=="invitedmegames" || action=="opengames") {
+    const auto listed=listedGames(username,action);
+    Data result{{"num",QString::number(listed.size())}};
+    for (size_t index=0;index<listed.size();++index) {
+      const auto& game=*listed[index];
+      Side role;
+      if (game.players[FIRST_SIDE]==username)
+        role=FIRST_SIDE;
+      else if (game.players[SECOND_SIDE]==username)
+        role=SECOND_SIDE;
+      else
+        role=(game.players[FIRST_SIDE].isEmpty() ? FIRST_SIDE : SECOND_SIDE);
+      const QStringList fields{"gid="+game.id,
+                               QString("role=")+toLetter(role),
+                               "timecontrol="+game.timeControl,
+                               QString("rated=")+(game.rated ? "1" : "0"),
+                               "postal=0",
+                               "createdts="+QString::number(game.createdts),
+                               "opponent="+game.players[otherSide(role)]};
+      result.insert(QString::number(index+1),fields.join('\n'));
+    }
+    return result;
+  }
+  else if (action=="state") {
+    Data result;
+    for (const auto category:{"mygames","invitedmegames","opengames","livegames","recentgames"}) {
+      QVariantList list;
+      for (const auto game:listedGames(username,category))
+        list.append(QVariantMap{{"id",game->id},
+                                {"timecontrol",game->timeControl},
+                                {"rated",game->rated ? "1" : "0"},
+                                {"postal","0"},
+                                {"createdts",QString::number(game->createdts)},
+                                {"wusername",game->players[FIRST_SIDE]},
+                                {"busername",game->players[SECOND_SIDE]}});
+      result.insert(category,list);
+    }
+    return result;
+  }
+  else
+    throw std::runtime_error("Unknown action: "+action.toStdString());
+}
+
+StandInServer::Data StandInServer::gameAction(const QString& action,const Request& request)
+{
+  const auto& items=request.items;
+  if (action=="sit") {
+    const auto reservation=reservations.find(items.value("grid"));
+    runtime_assert(reservation!=reservations.end() && reservation->second.gameID==items.value("tid"),"Invalid reservation.");
+    auto session=reservation->second;
+    reservations.erase(reservation);
+    const auto game=games.find(session.gameID);
+    runtime_assert(game!=games.end(),"Game was cancelled.");
+    session.auth=newID();
+    const auto sid=newID();
+    sessions[sid]=session;
+    const auto& players=game->second->players;
+    if (!game->second->started && !players[FIRST_SIDE].isEmpty() && !players[SECOND_SIDE].isEmpty())
+      startGame(*game->second);
+    return {{"sid",sid}};
+  }
+
+  const auto session_=sessions.find(items.value("sid"));
+  runtime_assert(session_!=sessions.end() && !session_->second.gameID.isEmpty(),"Invalid session ID.");
+  const auto session=session_->second;
+  const auto game_=games.find(session.gameID);
+  runtime_assert(game_!=games.end(),"Game was cancelled.");
+  auto& game=*game_->second;
+  if (action=="gamestate" || action=="updategamestate")
+    return gameState(game,session,items);
+  runtime_assert(items.value("auth")==session.auth,"Invalid authentication.");
+  if (action=="chat") {
+    game.chat+=session.username+": "+items.value("chat")+'\n';
+    changed(game);
+  }
+  else if (action=="startgame") {
+    runtime_assert(!game.players[FIRST_SIDE].isEmpty() && !game.players[SECOND_SIDE].isEmpty(),"Opponent has not arrived yet.");
+    if (!game.started)
+      startGame(game);
+  }
+  else if (action!="leave") {
+    runtime_assert(session.role!=NO_SIDE,"Spectators cannot play.");
+    runtime_assert(game.started && game.result.endCondition==NO_END,"Game is not in progress.");
+    if (action=="move") {
+      runtime_assert(game.node->gameState.sideToMove==session.role,"Not your turn.");
+      const auto move=items.value("move");
+      const auto newNode=Engine::applyMove(game.node,move);
+      runtime_assert(newNode!=nullptr,"Illegal move: "+move);
+      playMove(game,newNode);
+    }
+    else if (action=="resign")
+      finishGame(game,{otherSide(session.role),RESIGNATION});
+    else
+      throw std::runtime_error("Takebacks are not supported.");
+  }
+  return Data();
+}
+
+void StandInServer::respond(const Game& game,const Request& request) const
+{
+  const auto session=sessions.find(request.items.value("sid"));
+  if (session==sessions.end())
+    reply(request,{{"error","Invalid session ID."}});
+  else
+    reply(request,gameState(game,session->second,request.items));
+}
+
+void StandInServer::reply(const Request& request,const Data& data) const
+{
+  if (request.socket==nullptr)
+    return;
+  const auto body=encode(data,request.protocol);
+  request.socket->write(QByteArray("HTTP/1.1 200 OK\r\n")+
+                        "Content-Type: "+(request.protocol==1 ? "text/plain" : "application/json")+"\r\n"+
+                        "Content-Length: "+QByteArray::number(body.size())+"\r\n\r\n"+body);
+}
+
+QByteArray StandInServer::encode(const Data& data,const int protocol)
+{
+  if (protocol==1) {
+    QByteArray result;
+    for (auto entry=data.begin();entry!=data.end();++entry) {
+      auto value=entry.value().toString();
+      value.replace('%',"%25").replace('\n',"%13");
+      result+=(entry.key()+'='+value+'\n').toUtf8();
+    }
+    return result+"--END--\n";
+  }
+  else
+    return QJsonDocument(QJsonObject::fromVariantHash(data)).toJson(QJsonDocument::Compact);
+}
+
+StandInServer::Items StandInServer::decode(const QByteArray& body,const int protocol)
+{
+  Items result;
+  if (protocol==1) {
+    for (const auto& item:QUrlQuery(QString::fromUtf8(body)).queryItems(QUrl::FullyDecoded))
+      result.insert(item.first,item.second);
+  }
+  else {
+    const auto object=QJsonDocument::fromJson(body).object();
+    for (auto item=object.begin();item!=object.end();++item)
+      result.insert(item.key(),item.value().toString());
+  }
+  return result;
+}
+
+StandInServer::Game& StandInServer::newGame(const QString& timeControl,const bool rated)
+{
+  const auto game=new Game(this);
+  game->id=newID();
+  try {
+    game->timeLimits=Tournament::TimeLimits::parse(timeControl);
+    game->timeControl=timeControl;
+  }
+  catch (const std::exception&) {
+    game->timeLimits=defaultTimeLimits;
+    game->timeControl=defaultTimeControl;
+  }
+  game->bots={{false,false}};
+  game->rated=rated;
+  game->started=false;
+  game->createdts=QDateTime::currentMSecsSinceEpoch()/1000;
+  game->startTime=0;
+  game->node=Node::createTree().front();
+  game->lastChange=0;
+  game->reserves.fill(game->timeLimits.startingReserve);
+  game->result={NO_SIDE,NO_END};
+  game->botTimer.setSingleShot(true);
+  connect(&game->botTimer,&QTimer::timeout,game,[this,game]{playBotMove(*game);});
+  game->clockTimer.setSingleShot(true);
+  connect(&game->clockTimer,&QTimer::timeout,game,[this,game] {
+    finishGame(*game,{otherSide(game->node->gameState.sideToMove),TIME_OUT});
+  });
+  games[game->id]=game;
+  return *game;
+}
+
+StandInServer::Data StandInServer::reserveSeat(Game& game,const QString& username,const QString& role,const int protocol)
+{
+  Side side=NO_SIDE;
+  if (role!="v") {
+    side=(role.isEmpty() ? NO_SIDE : toSide(role[0].toLatin1()));
+    runtime_assert(side!=NO_SIDE,"Invalid role: "+role);
+    runtime_assert(game.players[side].isEmpty() || (game.players[side]==username && !game.bots[side]),"Seat is taken.");
+    if (game.players[side].isEmpty()) {
+      game.players[side]=username;
+      changed(game);
+      ensureOpenGames();
+    }
+  }
+  const auto grid=newID();
+  reservations[grid]={username,game.id,QString(),side};
+  const auto gameserverURL=QString("http://127.0.0.1:%1/client%2gs.cgi").arg(tcpServer.serverPort()).arg(protocol);
+  return {{"gid",game.id},{"tid",game.id},{"grid",grid},{"gsurl",gameserverURL}};
+}
+
+StandInServer::Data StandInServer::gameState(const Game& game,const Session& session,const Items& items) const
+{
+  const bool incremental=(items.value("action")=="updategamestate");
+  const auto sideToMove=game.node->gameState.sideToMove;
+  Data result{{"auth",session.auth},
+              {"timeonserver",QString::number(QDateTime::currentMSecsSinceEpoch()/1000)},
+              {"lastchange",QString::number(game.lastChange)},
+              {"moves",game.moves.mid(incremental ? items.value("moveslength").toInt() : 0)},
+              {"moveslength",QString::number(game.moves.size())},
+              {"chat",game.chat.mid(incremental ? items.value("chatlength").toInt() : 0)},
+              {"chatlength",QString::number(game.chat.size())},
+              {"wplayer",game.players[FIRST_SIDE]},
+              {"bplayer",game.players[SECOND_SIDE]},
+              {"turn",QString(toLetter(sideToMove))},
+              {"plycount",QString::number(game.node->depth)},
+              {"tcmove",QString::number(game.timeLimits.moveTime/1000)},
+              {"tcturntime",QString::number(game.timeLimits.absoluteMoveTime/1000)}};
+  const bool live=(game.started && game.result.endCondition==NO_END);
+  for (Side side=FIRST_SIDE;side<NUM_SIDES;increment(side)) {
+    const auto sideLetter=toLetter(side);
+    result.insert(QString("tc")+sideLetter+"reserve",QString::number(game.reserves[side]/1000));
+    result.insert(sideLetter+QString("used"),QString::number(live && side==sideToMove ? game.turnTimer.elapsed()/1000 : 0));
+  }
+  if (game.started)
+    result.insert("starttime",QString::number(game.startTime));
+  else if (!game.players[FIRST_SIDE].isEmpty() && !game.players[SECOND_SIDE].isEmpty())
+    result.insert("canstart","1");
+  if (game.result.endCondition!=NO_END)
+    result.insert("result",QString(toLetter(game.result.winner))+toChar(game.result.endCondition));
+  return result;
+}
+
+std::vector<const StandInServer::Game*> StandInServer::listedGames(const QString& username,const QString& category) const
+{
+  std::vector<const Game*> result;
+  for (const auto& entry:games) {
+    const auto& game=*entry.second;
+    const bool mine=(game.players[FIRST_SIDE]==username || game.players[SECOND_SIDE]==username);
+    const bool open=(!game.started && (game.players[FIRST_SIDE].isEmpty() || game.players[SECOND_SIDE].isEmpty()));
+    const bool finished=(game.result.endCondition!=NO_END);
+    if ((category=="mygames" && mine && !finished) ||
+        (category=="opengames" && open && !mine) ||
+        (category=="livegames" && game.started && !finished) ||
+        (category=="recentgames" && finished))
+      result.emplace_back(&game);
+  }
+  return result;
+}
+
+void StandInServer::startGame(Game& game)
+{
+  game.started=true;
+  game.startTime=QDateTime::currentMSecsSinceEpoch()/1000;
+  game.moves=QString::fromStdString(toPlyString(0,false)+' ');
+  nextTurn(game);
+}
+
+void StandInServer::nextTurn(Game& game)
+{
+  const auto side=game.node->gameState.sideToMove;
+  game.turnTimer.start();
+  game.clockTimer.start(game.timeLimits.allowed(game.reserves[side]));
+  if (game.bots[side])
+    game.botTimer.start(botDelay);
+  changed(game);
+}
+
+void StandInServer::playMove(Game& game,const NodePtr& newNode)
+{
+  const auto side=game.node->gameState.sideToMove;
+  if (!game.timeLimits.charge(game.reserves[side],game.turnTimer.elapsed()))
+    return finishGame(game,{otherSide(side),TIME_OUT});
+  game.moves+=QString::fromStdString(newNode->toString()+'\n'+toPlyString(newNode->depth,false)+' ');
+  game.node=newNode;
+  if (newNode->result.endCondition!=NO_END)
+    finishGame(game,newNode->result);
+  else
+    nextTurn(game);
+}
+
+void StandInServer::finishGame(Game& game,const Result& result)
+{
+  game.result=result;
+  game.botTimer.stop();
+  game.clockTimer.stop();
+  changed(game);
+}
+
+void StandInServer::changed(Game& game)
+{
+  ++game.lastChange;
+  const auto waiting=std::move(game.waiting);
+  game.waiting.clear();
+  for (const auto& request:waiting)
+    respond(game,request);
+}
+
+void StandInServer::playBotMove(Game& game)
+{
+  if (game.result.endCondition!=NO_END)
+    return;
+  const auto newNode=randomMove(game.node);
+  if (newNode==nullptr)
+    finishGame(game,{otherSide(game.node->gameState.sideToMove),IMMOBILIZATION});
+  else
+    playMove(game,newNode);
+}
+
+void StandInServer::ensureOpenGames()
+{
+  for (Side side=FIRST_SIDE;side<NUM_SIDES;increment(side)) {
+    bool found=false;
+    for (const auto& game:games)
+      if (!game.second->started && game.second->bots[side] && game.second->players[otherSide(side)].isEmpty())
+        found=true;
+    if (!found) {
+      auto& game=newGame(defaultTimeControl,false);
+      game.players[side]=QString("RandomBot")+toLetter(side);
+      game.bots[side]=true;
+    }
+  }
+}
+
+NodePtr StandInServer::randomMove(const NodePtr& node)
+{
+  const Side side=node->gameState.sideToMove;
+  if (node->inSetup()) {
+    std::vector<PieceTypeAndSide> pieces;
+    for (PieceType pieceType=FIRST_PIECE_TYPE;pieceType<NUM_PIECE_TYPES;increment(pieceType))
+      pieces.insert(pieces.end(),numStartingPiecesPerType[pieceType],toPieceTypeAndSide(pieceType,side));
+    std::shuffle(pieces.begin(),pieces.end(),generator);
+    Placements placements;
+    auto piece=pieces.begin();
+    for (SquareIndex square=FIRST_SQUARE;square<NUM_SQUARES;increment(square))
+      if (isSetupSquare(side,square))
+        placements.insert({square,*piece++});
+    return Node::addSetup(node,placements,true);
+  }
+
+  // Random walks are far cheaper than enumerating every legal move, which is only the fallback.
+  std::uniform_int_distribution<int> endDistribution(0,END_ODDS-1);
+  for (unsigned int walk=0;walk<MAX_RANDOM_WALKS;++walk) {
+    GameState gameState(node->gameState);
+    ExtendedSteps steps;
+    while (gameState.stepsAvailable>0) {
+      Steps candidates;
+      for (SquareIndex origin=FIRST_SQUARE;origin<NUM_SQUARES;increment(origin))
+        if (gameState.legalOrigin(origin))
+          for (const auto destination:gameState.legalDestinations(origin))
+            candidates.emplace_back(origin,destination);
+      if (candidates.empty())
+        break;
+      const auto& step=candidates[std::uniform_int_distribution<size_t>(0,candidates.size()-1)(generator)];
+      steps.emplace_back(gameState.takeExtendedStep(step.first,step.second));
+      if (!gameState.inPush && endDistribution(generator)==0)
+        break;
+    }
+    if (!steps.empty() && node->legalMove(steps)==MoveLegality::LEGAL)
+      return Node::makeMove(node,steps,true);
+  }
+  const auto moves=node->legalMoves();
+  if (moves.empty())
+    return nullptr;
+  return Node::makeMove(node,moves[std::uniform_int_distribution<size_t>(0,moves.size()-1)(generator)],true);
+}
+
+QString StandInServer::newID()
+{
+  return QString::number(++numIDs);
+}
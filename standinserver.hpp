@@ -0,0 +1,92 @@
+#ifndef STANDINSERVER_HPP
+#define STANDINSERVER_HPP
+
+#include <map>
+#include <random>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QPointer>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include "tournament.hpp"
+
+class StandInServer : public QObject {
+public:
+  StandInServer(const QString& timeControl,const int botDelay_,QObject* const parent=nullptr);
+  quint16 listen(const quint16 port=0);
+  QString gameroomURL(const int protocol) const;
+  QString addBotGame();
+  static int run(const quint16 port,const QString& timeControl,const unsigned int numBotGames,const int botDelay,QTextStream& log);
+private:
+  typedef QVariantHash Data;
+  typedef QHash<QString,QString> Items;
+
+  struct Request {
+    QPointer<QTcpSocket> socket;
+    int protocol;
+    Items items;
+    unsigned long long serial;
+  };
+  struct Game : public QObject {
+    explicit Game(QObject* const parent) : QObject(parent),botTimer(this),clockTimer(this) {}
+
+    QString id,timeControl;
+    Tournament::TimeLimits timeLimits;
+    std::array<QString,NUM_SIDES> players;
+    std::array<bool,NUM_SIDES> bots;
+    bool rated,started;
+    qint64 createdts,startTime;
+    NodePtr node;
+    QString moves,chat;
+    unsigned int lastChange;
+    std::array<qint64,NUM_SIDES> reserves;
+    Result result;
+    QElapsedTimer turnTimer;
+    std::vector<Request> waiting;
+    QTimer botTimer,clockTimer;
+  };
+  struct Session {
+    QString username,gameID,auth;
+    Side role;
+  };
+
+  void receive(QTcpSocket& socket);
+  void handle(Request request);
+  Data gameroomAction(const QString& action,const Request& request);
+  Data gameAction(const QString& action,const Request& request);
+  void respond(const Game& game,const Request& request) const;
+  void reply(const Request& request,const Data& data) const;
+  static QByteArray encode(const Data& data,const int protocol);
+  static Items decode(const QByteArray& body,const int protocol);
+
+  Game& newGame(const QString& timeControl,const bool rated);
+  Data reserveSeat(Game& game,const QString& username,const QString& role,const int protocol);
+  Data gameState(const Game& game,const Session& session,const Items& items) const;
+  std::vector<const Game*> listedGames(const QString& username,const QString& category) const;
+  void startGame(Game& game);
+  void nextTurn(Game& game);
+  void playMove(Game& game,const NodePtr& newNode);
+  void finishGame(Game& game,const Result& result);
+  void changed(Game& game);
+  void playBotMove(Game& game);
+  void ensureOpenGames();
+  NodePtr randomMove(const NodePtr& node);
+  QString newID();
+
+  static constexpr int MAX_WAIT=30*1000;
+  static constexpr unsigned int MAX_RANDOM_WALKS=16;
+  static constexpr int END_ODDS=4;
+
+  QTcpServer tcpServer;
+  const QString defaultTimeControl;
+  const Tournament::TimeLimits defaultTimeLimits;
+  const int botDelay;
+  std::mt19937_64 generator;
+  std::map<QTcpSocket*,QByteArray> buffers;
+  std::map<QString,Game*> games;
+  std::map<QString,Session> sessions,reservations;
+  unsigned long long numIDs,numRequests;
+};
+
+#endif // STANDINSERVER_HPP
@@ -10,9 +10,12 @@ StartAnalysis::StartAnalysis(Globals& globals_,const NodePtr& node_,const std::p
   globals(globals_),
   node(Node::reroot(node_)),
   partialMove(partialMove_),
+  partialMovePossible(partialMove.second.empty() ? !partialMove.first.empty() : node->legalPartialMove(partialMove.second)),
   vBoxLayout(this),
   executableLabel(tr("Executable:")),
   executablePushButton(tr("&Locate")),
+  aei(tr("Persistent &AEI session")),
+  refine(tr("Re&fine cached analysis")),
   argumentGroupBox(tr("Arguments (line-separated)")),
   partialMoveGroupBox(tr("Partial &move")),
   dialogButtonBox(QDialogButtonBox::Ok|QDialogButtonBox::Cancel)
@@ -29,6 +32,13 @@ StartAnalysis::StartAnalysis(Globals& globals_,const NodePtr& node_,const std::p
 
   vBoxLayout.addLayout(&executable);
 
+  aei.setToolTip(tr("Keep the engine running between analyses and send positions over the Arimaa Engine Interface"));
+  connect(&aei,&QCheckBox::toggled,this,&StartAnalysis::setAEI);
+  vBoxLayout.addWidget(&aei);
+
+  refine.setToolTip(tr("Run the engine again after showing a cached analysis of the same position and configuration"));
+  vBoxLayout.addWidget(&refine);
+
   for (auto& textEdit:arguments) {
     textEdit.setAcceptRichText(false);
     textEdit.setLineWrapMode(QTextEdit::NoWrap);
@@ -43,7 +53,6 @@ StartAnalysis::StartAnalysis(Globals& globals_,const NodePtr& node_,const std::p
 
   const auto& setup=partialMove.first;
   const auto& move=partialMove.second;
-  const bool partialMovePossible=(move.empty() ? !setup.empty() : node->legalPartialMove(move));
   partialMoveGroupBox.setCheckable(true);
   partialMoveGroupBox.setChecked(partialMovePossible);
   partialMoveGroupBox.setEnabled(partialMovePossible);
@@ -77,28 +86,49 @@ StartAnalysis::StartAnalysis(Globals& globals_,const NodePtr& node_,const std::p
 
   connect(&dialogButtonBox,&QDialogButtonBox::accepted,this,[=] {
     setEnabled(false);
-    Analysis::CommandLine commandLine;
-    commandLine.executable=executableLineEdit.text();
-    commandLine.beforeMoves=split(arguments[0]);
-    commandLine.moves=moveFileContent.text();
-
-    commandLine.afterMoves=split(arguments[1]);
-    if (partialMoveGroupBox.isChecked()) {
-      commandLine.afterMoves.append(split(partialMoveArguments[0]));
-      commandLine.afterMoves.append(partialMoveLine.text());
-      commandLine.afterMoves.append(split(partialMoveArguments[1]));
-    }
-    commandLine.afterMoves.append(split(arguments[2]));
-
     std::set<std::string> words;
     for (const auto& word:passSynonyms.text().split(" ",Qt::SkipEmptyParts))
       words.emplace(word.toStdString());
 
-    const auto analysis=new Analysis(globals,node,partialMoveGroupBox.isChecked() ? partialMove : std::pair<Placements,ExtendedSteps>(),commandLine,words,this);
-    if (analysis->isHidden() && analysis->process.state()==QProcess::NotRunning)
+    Analysis* analysis;
+    if (aei.isChecked()) {
+      Engine::Configuration configuration;
+      configuration.executable=executableLineEdit.text();
+      for (const auto& textEdit:arguments)
+        configuration.arguments.append(split(textEdit));
+      const auto cacheKey=AnalysisCache::key(node,std::pair<Placements,ExtendedSteps>(),configuration.executable,configuration.arguments,true);
+      const auto cached=AnalysisCache::load(cacheKey);
+      if (!cached.empty() && !refine.isChecked())
+        analysis=new Analysis(globals,node,std::pair<Placements,ExtendedSteps>(),cached,words,this);
+      else
+        analysis=new Analysis(globals,node,Engine::acquire(configuration),words,cacheKey,cached,this);
+    }
+    else {
+      Analysis::CommandLine commandLine;
+      commandLine.executable=executableLineEdit.text();
+      commandLine.beforeMoves=split(arguments[0]);
+      commandLine.moves=moveFileContent.text();
+
+      commandLine.afterMoves=split(arguments[1]);
+      if (partialMoveGroupBox.isChecked()) {
+        commandLine.afterMoves.append(split(partialMoveArguments[0]));
+        commandLine.afterMoves.append(partialMoveLine.text());
+        commandLine.afterMoves.append(split(partialMoveArguments[1]));
+      }
+      commandLine.afterMoves.append(split(arguments[2]));
+
+      const auto analyzedMove=(partialMoveGroupBox.isChecked() ? partialMove : std::pair<Placements,ExtendedSteps>());
+      const auto cacheKey=AnalysisCache::key(node,analyzedMove,commandLine.executable,QStringList(commandLine.beforeMoves)<<commandLine.moves<<commandLine.afterMoves,false);
+      const auto cached=AnalysisCache::load(cacheKey);
+      if (!cached.empty() && !refine.isChecked())
+        analysis=new Analysis(globals,node,analyzedMove,cached,words,this);
+      else
+        analysis=new Analysis(globals,node,analyzedMove,commandLine,words,cacheKey,cached,this);
+    }
+    if (analysis->isHidden() && !analysis->running())
       setEnabled(true);
-    connect(&analysis->process,&QProcess::errorOccurred,this,[this]{setEnabled(true);});
-    connect(&analysis->process,&QProcess::readyReadStandardOutput,this,[=] {
+    connect(analysis,&Analysis::failed,this,[this]{setEnabled(true);});
+    connect(analysis,&Analysis::receivedOutput,this,[=] {
       setEnabled(true);
       writeSettings(globals.settings);
       analysis->setParent(game,Qt::Window);
@@ -128,11 +158,18 @@ QStringList StartAnalysis::split(const QTextEdit& textEdit)
 void StartAnalysis::setWindowTitle()
 {
   QString position=QString::fromStdString(node->nextPlyString());
-  if (partialMoveGroupBox.isChecked())
+  if (partialMoveGroupBox.isEnabled() && partialMoveGroupBox.isChecked())
     position+=' '+partialMoveLine.text();
   QDialog::setWindowTitle(tr("Analyze %1").arg(position));
 }
 
+void StartAnalysis::setAEI(const bool on)
+{
+  moveFileContent.setEnabled(!on);
+  partialMoveGroupBox.setEnabled(!on && partialMovePossible);
+  setWindowTitle();
+}
+
 void StartAnalysis::readSettings(QSettings& settings)
 {
   settings.beginGroup("Analysis");
@@ -145,6 +182,8 @@ void StartAnalysis::readSettings(QSettings& settings)
   partialMoveArguments[1].setText(settings.value("after_partial_move").toString());
   arguments[2].setText(settings.value("last_arguments").toString());
   passSynonyms.setText(settings.value("pass_synonyms","qpss").toString());
+  aei.setChecked(settings.value("aei",false).toBool());
+  refine.setChecked(settings.value("refine",false).toBool());
   settings.endGroup();
 }
 
@@ -152,6 +191,8 @@ void StartAnalysis::writeSettings(QSettings& settings) const
 {
   settings.beginGroup("Analysis");
   settings.setValue("executable",executableLineEdit.text());
+  settings.setValue("aei",aei.isChecked());
+  settings.setValue("refine",refine.isChecked());
   settings.setValue("first_arguments",arguments[0].toPlainText());
   settings.setValue("middle_arguments",arguments[1].toPlainText());
   if (partialMoveGroupBox.isEnabled()) {
@@ -7,6 +7,7 @@ class QSettings;
 #include <QLabel>
 #include <QLineEdit>
 #include <QPushButton>
+#include <QCheckBox>
 #include <QGroupBox>
 #include <QTextEdit>
 #include <QFormLayout>
@@ -22,18 +23,22 @@ public:
 private:
   static QStringList split(const QTextEdit& textEdit);
   void setWindowTitle();
+  void setAEI(const bool on);
   void readSettings(QSettings& settings);
   void writeSettings(QSettings& settings) const;
 
   Globals& globals;
   const NodePtr node;
   const std::pair<Placements,ExtendedSteps> partialMove;
+  const bool partialMovePossible;
 
   QVBoxLayout vBoxLayout;
     QHBoxLayout executable;
       QLabel executableLabel;
       QLineEdit executableLineEdit;
       QPushButton executablePushButton;
+    QCheckBox aei;
+    QCheckBox refine;
     QGroupBox argumentGroupBox;
       QVBoxLayout argumentLayout;
         std::array<QTextEdit,3> arguments;
@@ -0,0 +1,213 @@
+#include "threatannotator.hpp"
+#include "alphabeta.hpp"
+
+ThreatAnnotator::ThreatAnnotator(QObject* const parent) :
+  QObject(parent),
+  worker(new QObject)
+{
+  worker->moveToThread(&thread);
+  connect(&thread,&QThread::finished,worker,&QObject::deleteLater);
+  thread.start(QThread::LowPriority);
+}
+
+ThreatAnnotator::~ThreatAnnotator()
+{
+  thread.requestInterruption();
+  thread.quit();
+  thread.wait();
+}
+
+void ThreatAnnotator::annotate(const NodePtr& root)
+{
+  if (root==nullptr)
+    return;
+  std::vector<NodePtr> stack{root};
+  while (!stack.empty()) {
+    const auto node=stack.back();
+    stack.pop_back();
+    for (int childIndex=node->numChildren()-1;childIndex>=0;--childIndex)
+      if (const auto child=node->child(childIndex))
+        stack.emplace_back(child);
+    if ((node->threats&Node::THREATS_SCANNED)!=0 || queued.find(node.get())!=queued.end())
+      continue;
+    if (node->move.empty() || node->result.endCondition!=NO_END) {
+      node->threats=Node::THREATS_SCANNED;
+      continue;
+    }
+    queued.insert(node.get());
+    // The tree is only touched on this thread, so the worker gets copies of the states.
+    const auto this_=this;
+    const GameState gameState(node->gameState);
+    const GameState previousState(node->previousNode->gameState);
+    QMetaObject::invokeMethod(worker,[this_,node,gameState,previousState] {
+      if (QThread::currentThread()->isInterruptionRequested())
+        return;
+      const auto result=threats(gameState,previousState);
+      QMetaObject::invokeMethod(this_,[this_,node,result]{this_->receive(node,result);},Qt::QueuedConnection);
+    },Qt::QueuedConnection);
+  }
+}
+
+void ThreatAnnotator::receive(const NodePtr& node,const unsigned int threats)
+{
+  queued.erase(node.get());
+  node->threats=threats|Node::THREATS_SCANNED;
+  if (threats!=0)
+    emit annotated(node);
+}
+
+unsigned int ThreatAnnotator::threats(const GameState& gameState,const GameState& previousState,const unsigned int goalMoves)
+{
+  GameState threatState(gameState);
+  threatState.switchTurn();
+  unsigned int result=0;
+  if (goalIn(threatState,1))
+    result|=Node::GOAL_THREAT;
+  if (captureThreat(threatState))
+    result|=Node::CAPTURE_THREAT;
+  // A move that keeps a forced goal on track is not a missed win, even if the goal lies further ahead.
+  if (goalIn(previousState,goalMoves) && !goalAfterEveryReply(gameState,previousState.sideToMove,goalMoves-1))
+    result|=Node::MISSED_WIN;
+  return result;
+}
+
+bool ThreatAnnotator::goalIn(const GameState& gameState,const unsigned int numMoves)
+{
+  if (numMoves==0 || !goalInRange(gameState,numMoves))
+    return false;
+  const auto side=gameState.sideToMove;
+  bool found=false;
+  AlphaBeta::forEachMove(gameState,[&](const GameState& state) {
+    if (QThread::currentThread()->isInterruptionRequested())
+      return true;
+    GameState finalState(state);
+    finalState.switchTurn();
+    found=(Node::goalOrElimination(finalState).winner==side);
+    return found;
+  });
+  if (found || numMoves==1)
+    return found;
+  AlphaBeta::forEachMove(gameState,[&](const GameState& state) {
+    if (QThread::currentThread()->isInterruptionRequested())
+      return true;
+    GameState finalState(state);
+    finalState.switchTurn();
+    if (Node::goalOrElimination(finalState).endCondition==NO_END && goalInRange(finalState,side,numMoves-1))
+      found=goalAfterEveryReply(finalState,side,numMoves-1);
+    return found;
+  });
+  return found;
+}
+
+bool ThreatAnnotator::goalAfterEveryReply(const GameState& gameState,const Side side,const unsigned int numMoves)
+{
+  if (numMoves==0)
+    return false;
+  bool refuted=false;
+  AlphaBeta::forEachMove(gameState,[&](const GameState& state) {
+    if (QThread::currentThread()->isInterruptionRequested()) {
+      refuted=true;
+      return true;
+    }
+    GameState finalState(state);
+    finalState.switchTurn();
+    const auto result=Node::goalOrElimination(finalState);
+    refuted=(result.endCondition==NO_END ? !goalIn(finalState,numMoves) : result.winner!=side);
+    return refuted;
+  });
+  return !refuted;
+}
+
+bool ThreatAnnotator::goalInRange(const GameState& gameState,const unsigned int numMoves)
+{
+  return goalInRange(gameState,gameState.sideToMove,numMoves);
+}
+
+bool ThreatAnnotator::goalInRange(const GameState& gameState,const Side side,const unsigned int numMoves)
+{
+  const int numSteps=(gameState.sideToMove==side ? gameState.stepsAvailable : MAX_STEPS_PER_MOVE)+(numMoves-1)*MAX_STEPS_PER_MOVE;
+  // Lower bound on the steps a rabbit needs: every occupied square on its way costs at least one extra step to clear.
+  std::array<int,NUM_SQUARES> rabbitSteps;
+  rabbitSteps.fill(NUM_SQUARES);
+  unsigned int numOpponentRabbits=0;
+  for (SquareIndex square=FIRST_SQUARE;square<NUM_SQUARES;increment(square)) {
+    const auto piece=gameState.squarePieces[square];
+    if (piece==NO_PIECE || toPieceType(piece)!=WINNING_PIECE_TYPE)
+      continue;
+    if (toSide(piece)!=side)
+      ++numOpponentRabbits;
+    else
+      rabbitSteps[square]=(gameState.sideToMove==side && gameState.isFrozen(square) ? 1 : 0);
+  }
+  if (numOpponentRabbits<=2*numMoves)
+    return true;
+  for (bool changed=true;changed;) {
+    changed=false;
+    for (SquareIndex square=FIRST_SQUARE;square<NUM_SQUARES;increment(square)) {
+      if (rabbitSteps[square]>=numSteps)
+        continue;
+      for (const auto adjacentSquare:adjacentSquares(square)) {
+        const int steps=rabbitSteps[square]+(gameState.squarePieces[adjacentSquare]==NO_PIECE ? 1 : 2);
+        if (!restrictedDirection(side,square,adjacentSquare) && steps<rabbitSteps[adjacentSquare]) {
+          rabbitSteps[adjacentSquare]=steps;
+          changed=true;
+        }
+      }
+    }
+  }
+  for (SquareIndex square=FIRST_SQUARE;square<NUM_SQUARES;increment(square))
+    if (isGoal(square,side) && rabbitSteps[square]<=numSteps)
+      return true;
+  return false;
+}
+
+bool ThreatAnnotator::captureThreat(const GameState& gameState)
+{
+  const auto side=gameState.sideToMove;
+  for (const auto trap:getTrapSquares()) {
+    Squares defenders;
+    for (const auto adjacentSquare:adjacentSquares(trap))
+      if (isSide(gameState.squarePieces[adjacentSquare],otherSide(side)))
+        defenders.emplace_back(adjacentSquare);
+    if (defenders.empty() || defenders.size()>2)
+      continue;
+    if (isSide(gameState.squarePieces[trap],otherSide(side))) {
+      if (defenders.size()==1 && displacementSteps(gameState,defenders.front(),NO_SQUARE)<=gameState.stepsAvailable)
+        return true;
+      continue;
+    }
+    for (const auto victim:defenders) {
+      int numSteps=displacementSteps(gameState,victim,trap);
+      if (defenders.size()==2)
+        numSteps+=displacementSteps(gameState,defenders.front()==victim ? defenders.back() : defenders.front(),NO_SQUARE);
+      if (numSteps<=gameState.stepsAvailable)
+        return true;
+    }
+  }
+  return false;
+}
+
+int ThreatAnnotator::displacementSteps(const GameState& gameState,const SquareIndex victim,const SquareIndex destination)
+{
+  const auto& board=gameState.squarePieces;
+  const auto hasEmptyNeighbor=[&](const SquareIndex square) {
+    for (const auto adjacentSquare:adjacentSquares(square))
+      if (board[adjacentSquare]==NO_PIECE)
+        return true;
+    return false;
+  };
+  int result=NUM_SQUARES;
+  for (SquareIndex square=FIRST_SQUARE;square<NUM_SQUARES;increment(square)) {
+    if (!isSide(board[square],gameState.sideToMove) || !dominates(board[square],board[victim]) || gameState.isFrozen(square))
+      continue;
+    const int approach=distance(square,victim)-1;
+    bool feasible;
+    if (destination==NO_SQUARE)
+      feasible=hasEmptyNeighbor(victim) || (approach==0 && hasEmptyNeighbor(square));
+    else
+      feasible=(board[destination]==NO_PIECE) || (square==destination && hasEmptyNeighbor(square));
+    if (feasible)
+      result=std::min(result,approach+2);
+  }
+  return result;
+}
@@ -0,0 +1,33 @@
+#ifndef THREATANNOTATOR_HPP
+#define THREATANNOTATOR_HPP
+
+#include <unordered_set>
+#include <QThread>
+#include "node.hpp"
+
+class ThreatAnnotator : public QObject {
+  Q_OBJECT
+public:
+  explicit ThreatAnnotator(QObject* const parent=nullptr);
+  ~ThreatAnnotator();
+  void annotate(const NodePtr& root);
+  static unsigned int threats(const GameState& gameState,const GameState& previousState,const unsigned int goalMoves=DEFAULT_GOAL_MOVES);
+  static bool goalIn(const GameState& gameState,const unsigned int numMoves);
+  static bool captureThreat(const GameState& gameState);
+
+  static constexpr unsigned int DEFAULT_GOAL_MOVES=2;
+private:
+  static bool goalAfterEveryReply(const GameState& gameState,const Side side,const unsigned int numMoves);
+  static bool goalInRange(const GameState& gameState,const unsigned int numMoves);
+  static bool goalInRange(const GameState& gameState,const Side side,const unsigned int numMoves);
+  static int displacementSteps(const GameState& gameState,const SquareIndex victim,const SquareIndex destination);
+  void receive(const NodePtr& node,const unsigned int threats);
+
+  QThread thread;
+  QObject* const worker;
+  std::unordered_set<const Node*> queued;
+signals:
+  void annotated(const NodePtr& node);
+};
+
+#endif // THREATANNOTATOR_HPP
@@ -1,6 +1,14 @@
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 #include "timeestimator.hpp"
 
+TimeEstimator::TimeEstimator() :
+  serverToLocalOffset(0),
+  smoothedJitter(0)
+{
+}
+
 void TimeEstimator::add(const QDateTime& postTime,const QDateTime& replyTime,const bool instantResponse,const QVariant& timeOnServer)
 {
   assert(postTime.isValid());
@@ -10,12 +18,18 @@ void TimeEstimator::add(const QDateTime& postTime,const QDateTime& replyTime,con
   }
   if (instantResponse) {
     const auto roundTripTime=postTime.msecsTo(replyTime);
-    insertSorted(roundTripTimes,roundTripTime);
+    // Smoothed the same way as RTP interarrival jitter (RFC 3550).
+    if (!roundTripTimes.empty())
+      smoothedJitter+=(std::abs(roundTripTime-roundTripTimes.samples().back())-smoothedJitter)/16;
+    roundTripTimes.add(roundTripTime);
     if (timeOnServer.isValid())
-      estimatedServerToLocalOffsets.push_back(lastTimeOnServer.msecsTo(replyTime.addMSecs(-roundTripTime/2)));
+      estimatedServerToLocalOffsets.add(lastTimeOnServer.msecsTo(replyTime.addMSecs(-roundTripTime/2)));
+    updateServerToLocalOffset();
+  }
+  else if (timeOnServer.isValid()) {
+    estimatedServerToLocalPlusReplyOffsets.add(lastTimeOnServer.msecsTo(replyTime));
+    updateServerToLocalOffset();
   }
-  else if (timeOnServer.isValid())
-    estimatedServerToLocalPlusReplyOffsets.push_back(lastTimeOnServer.msecsTo(replyTime));
 }
 
 qint64 TimeEstimator::estimatedRoundTripTime() const
@@ -23,33 +37,41 @@ qint64 TimeEstimator::estimatedRoundTripTime() const
   if (roundTripTimes.empty())
     return 0;
   else
-    return medianSorted(roundTripTimes);
+    return roundTripTimes.median();
+}
+
+qint64 TimeEstimator::roundTripTimePercentile(const double fraction) const
+{
+  if (roundTripTimes.empty())
+    return 0;
+  else
+    return roundTripTimes.percentile(fraction);
+}
+
+qint64 TimeEstimator::jitter() const
+{
+  return std::llround(smoothedJitter);
 }
 
 qint64 TimeEstimator::estimatedExtraTime() const
 {
-  const auto numEstimates=estimatedServerToLocalOffsets.size()+estimatedServerToLocalPlusReplyOffsets.size();
-  if (numEstimates==0)
+  if (estimatedServerToLocalOffsets.empty() && estimatedServerToLocalPlusReplyOffsets.empty())
     return 0;
-  std::vector<qint64> allEstimatedServerToLocal;
-  allEstimatedServerToLocal.reserve(numEstimates);
-  allEstimatedServerToLocal.insert(allEstimatedServerToLocal.end(),estimatedServerToLocalOffsets.begin(),estimatedServerToLocalOffsets.end());
-  const auto estimatedReplyTime=estimatedRoundTripTime()/2;
-  for (const auto& estimatedServerToLocalPlusReplyOffset:estimatedServerToLocalPlusReplyOffsets)
-    allEstimatedServerToLocal.push_back(estimatedServerToLocalPlusReplyOffset-estimatedReplyTime);
-  const auto estimatedTurnTime=std::max(referenceTime,lastTimeOnServer.addMSecs(medianUnsorted(allEstimatedServerToLocal)));
+  const auto estimatedTurnTime=std::max(referenceTime,lastTimeOnServer.addMSecs(serverToLocalOffset));
   return estimatedTurnTime.msecsTo(QDateTime::currentDateTimeUtc());
 }
 
-qint64 TimeEstimator::medianSorted(const std::vector<qint64>& multiset)
+void TimeEstimator::updateServerToLocalOffset()
 {
-  auto iter=next(multiset.begin(),multiset.size()/2);
-  if (multiset.size()%2==0) {
-    const auto high=*iter--;
-    return (high+*iter)/2;
-  }
-  else
-    return *iter;
+  const auto& offsets=estimatedServerToLocalOffsets.samples();
+  const auto& plusReplyOffsets=estimatedServerToLocalPlusReplyOffsets.samples();
+  if (offsets.empty() && plusReplyOffsets.empty())
+    return;
+  allEstimatedServerToLocal.assign(offsets.begin(),offsets.end());
+  const auto estimatedReplyTime=estimatedRoundTripTime()/2;
+  for (const auto& estimatedServerToLocalPlusReplyOffset:plusReplyOffsets)
+    allEstimatedServerToLocal.push_back(estimatedServerToLocalPlusReplyOffset-estimatedReplyTime);
+  serverToLocalOffset=medianUnsorted(allEstimatedServerToLocal);
 }
 
 qint64 TimeEstimator::medianUnsorted(std::vector<qint64>& multiset)
@@ -63,7 +85,31 @@ qint64 TimeEstimator::medianUnsorted(std::vector<qint64>& multiset)
     return *iter;
 }
 
-void TimeEstimator::insertSorted(std::vector<qint64>& vector,const qint64 element)
+void TimeEstimator::Window::add(const qint64 sample)
+{
+  if (chronological.size()==CAPACITY) {
+    sorted.erase(lower_bound(sorted.begin(),sorted.end(),chronological.front()));
+    chronological.pop_front();
+  }
+  chronological.push_back(sample);
+  sorted.insert(upper_bound(sorted.begin(),sorted.end(),sample),sample);
+}
+
+qint64 TimeEstimator::Window::median() const
+{
+  assert(!empty());
+  auto iter=next(sorted.begin(),sorted.size()/2);
+  if (sorted.size()%2==0) {
+    const auto high=*iter--;
+    return (high+*iter)/2;
+  }
+  else
+    return *iter;
+}
+
+qint64 TimeEstimator::Window::percentile(const double fraction) const
 {
-  vector.insert(upper_bound(vector.begin(),vector.end(),element),element);
+  assert(!empty() && fraction>=0 && fraction<=1);
+  const auto rank=static_cast<std::size_t>(std::ceil(fraction*sorted.size()));
+  return sorted[rank==0 ? 0 : rank-1];
 }
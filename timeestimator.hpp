@@ -1,19 +1,40 @@
 #ifndef TIMEESTIMATOR_HPP
 #define TIMEESTIMATOR_HPP
 
+#include <deque>
+#include <vector>
 #include <QDateTime>
 #include <QVariant>
 
 class TimeEstimator {
 public:
+  TimeEstimator();
   void add(const QDateTime& postTime,const QDateTime& replyTime,const bool instantResponse,const QVariant& timeOnServer);
   qint64 estimatedRoundTripTime() const;
+  qint64 roundTripTimePercentile(const double fraction) const;
+  qint64 jitter() const;
   qint64 estimatedExtraTime() const;
 private:
-  static qint64 medianSorted(const std::vector<qint64>& multiset);
+  class Window {
+  public:
+    void add(const qint64 sample);
+    bool empty() const {return sorted.empty();}
+    qint64 median() const;
+    qint64 percentile(const double fraction) const;
+    const std::deque<qint64>& samples() const {return chronological;}
+  private:
+    static constexpr std::size_t CAPACITY=64;
+    std::deque<qint64> chronological;
+    std::vector<qint64> sorted;
+  };
+
+  void updateServerToLocalOffset();
   static qint64 medianUnsorted(std::vector<qint64>& multiset);
-  static void insertSorted(std::vector<qint64>& vector,const qint64 element);
-  std::vector<qint64> roundTripTimes,estimatedServerToLocalOffsets,estimatedServerToLocalPlusReplyOffsets;
+
+  Window roundTripTimes,estimatedServerToLocalOffsets,estimatedServerToLocalPlusReplyOffsets;
+  std::vector<qint64> allEstimatedServerToLocal;
+  qint64 serverToLocalOffset;
+  double smoothedJitter;
   QDateTime lastTimeOnServer,referenceTime;
 };
 
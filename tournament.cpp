@@ -0,0 +1,249 @@
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QThread>
+#include <QRegularExpression>
+#include "tournament.hpp"
+#include "alphabeta.hpp"
+#include "io.hpp"
+
+using namespace std;
+Tournament::TimeLimits Tournament::TimeLimits::parse(const QString& timeControl)
+{
+  const auto fields=timeControl.split('/');
+  runtime_assert(fields.size()>=2 && fields.size()<=6,"Invalid time control: "+timeControl);
+  TimeLimits result;
+  result.moveTime=parseDuration(fields[0]);
+  result.startingReserve=parseDuration(fields[1]);
+  bool ok=true;
+  result.carryover=(fields.size()>2 ? fields[2].toInt(&ok) : 100);
+  runtime_assert(ok && result.carryover>=0 && result.carryover<=100,"Invalid carryover percentage: "+timeControl);
+  result.maxReserve=(fields.size()>3 ? parseDuration(fields[3]) : 0);
+  result.totalGameTime=0;
+  result.maxTurns=0;
+  if (fields.size()>4) {
+    if (fields[4].endsWith('t')) {
+      result.maxTurns=fields[4].left(fields[4].size()-1).toInt(&ok);
+      runtime_assert(ok && result.maxTurns>=0,"Invalid number of turns: "+timeControl);
+    }
+    else
+      result.totalGameTime=parseDuration(fields[4]);
+  }
+  result.absoluteMoveTime=(fields.size()>5 ? parseDuration(fields[5]) : 0);
+  runtime_assert(result.moveTime>0,"Time control has no time per move: "+timeControl);
+  return result;
+}
+
+qint64 Tournament::TimeLimits::allowed(const qint64 reserve) const
+{
+  const auto result=moveTime+reserve;
+  return absoluteMoveTime>0 ? std::min(result,absoluteMoveTime) : result;
+}
+
+bool Tournament::TimeLimits::charge(qint64& reserve,const qint64 used) const
+{
+  if (used>moveTime)
+    reserve-=used-moveTime;
+  else
+    reserve+=(moveTime-used)*carryover/100;
+  if (maxReserve>0)
+    reserve=std::min(reserve,maxReserve);
+  return reserve>=0 && (absoluteMoveTime<=0 || used<=absoluteMoveTime);
+}
+
+qint64 Tournament::TimeLimits::parseDuration(const QString& duration)
+{
+  qint64 seconds=0;
+  bool ok=true;
+  if (duration.contains(':')) {
+    for (const auto& part:duration.split(':')) {
+      seconds=seconds*60+part.toInt(&ok);
+      runtime_assert(ok,"Invalid duration: "+duration);
+    }
+  }
+  else if (duration.contains(QRegularExpression("[dhms]"))) {
+    const QRegularExpression unitExpression("^(\\d+)([dhms])");
+    for (QString rest=duration;!rest.isEmpty();) {
+      const auto match=unitExpression.match(rest);
+      runtime_assert(match.hasMatch(),"Invalid duration: "+duration);
+      const auto value=match.captured(1).toLongLong();
+      switch (match.captured(2).at(0).toLatin1()) {
+        case 'd': seconds+=value*24*60*60; break;
+        case 'h': seconds+=value*60*60; break;
+        case 'm': seconds+=value*60; break;
+        case 's': seconds+=value; break;
+      }
+      rest.remove(0,match.capturedLength());
+    }
+  }
+  else {
+    seconds=duration.toLongLong(&ok)*60;
+    runtime_assert(ok,"Invalid duration: "+duration);
+  }
+  return seconds*1000;
+}
+
+Tournament::Tournament(const std::vector<Engine::Configuration>& players_,const TimeLimits& timeLimits_,const unsigned int gamesPerPairing,const unsigned int numConcurrentGames_,QFile& archive_,QTextStream& log_,QObject* const parent) :
+  QObject(parent),
+  players(players_),
+  timeLimits(timeLimits_),
+  numConcurrentGames(std::max(1u,numConcurrentGames_)),
+  archive(archive_),
+  log(log_),
+  scores(players.size(),{{0,0}}),
+  numStarted(0)
+{
+  for (unsigned int gameIndex=0;gameIndex<gamesPerPairing;++gameIndex)
+    for (size_t first=0;first<players.size();++first)
+      for (size_t second=first+1;second<players.size();++second)
+        pairings.push_back(gameIndex%2==0 ? array<size_t,NUM_SIDES>{{first,second}} : array<size_t,NUM_SIDES>{{second,first}});
+}
+
+void Tournament::start()
+{
+  archive.write("id\tgold\tsilver\twinner\treason\tturns\tmovelist\n");
+  archive.flush();
+  while (matches.size()<numConcurrentGames && !pairings.empty()) {
+    startMatch(pairings.front());
+    pairings.pop_front();
+  }
+  if (matches.empty())
+    emit finished();
+}
+
+int Tournament::run(const QString& playerList,const QString& timeControl,const unsigned int gamesPerPairing,const QString& archiveName,QTextStream& log)
+{
+  QFile playerFile(playerList);
+  runtime_assert(playerFile.open(QIODevice::ReadOnly|QIODevice::Text),playerFile.errorString());
+  std::vector<Engine::Configuration> players;
+  while (!playerFile.atEnd()) {
+    const auto line=QString::fromUtf8(playerFile.readLine()).trimmed();
+    if (line.isEmpty() || line.startsWith('#'))
+      continue;
+    auto arguments=QProcess::splitCommand(line);
+    Engine::Configuration configuration;
+    configuration.executable=arguments.takeFirst();
+    configuration.arguments=arguments;
+    players.emplace_back(configuration);
+  }
+  runtime_assert(players.size()>=2,"At least two players are needed.");
+
+  QFile archive(archiveName);
+  runtime_assert(archive.open(QIODevice::WriteOnly|QIODevice::Text),archive.errorString());
+  Tournament tournament(players,TimeLimits::parse(timeControl),gamesPerPairing,std::max(1,QThread::idealThreadCount()/2),archive,log);
+  connect(&tournament,&Tournament::finished,QCoreApplication::instance(),&QCoreApplication::quit,Qt::QueuedConnection);
+  tournament.start();
+  QCoreApplication::exec();
+
+  for (size_t player=0;player<players.size();++player)
+    log<<QCoreApplication::translate("Tournament","%1: %2 win(s), %3 loss(es)").arg(tournament.playerName(player)).arg(tournament.scores[player][0]).arg(tournament.scores[player][1])<<'\n';
+  return EXIT_SUCCESS;
+}
+
+void Tournament::startMatch(const std::array<size_t,NUM_SIDES>& players_)
+{
+  matches.emplace_back(new Match(this));
+  auto& match=*matches.back();
+  match.players=players_;
+  match.node=Node::createTree().front();
+  match.turns=0;
+  match.id=++numStarted;
+  match.timeout.setSingleShot(true);
+  connect(&match.timeout,&QTimer::timeout,&match,[this,&match] {
+    finishMatch(match,{otherSide(match.node->gameState.sideToMove),TIME_OUT});
+  });
+  for (Side side=FIRST_SIDE;side<NUM_SIDES;increment(side)) {
+    match.reserves[side]=timeLimits.startingReserve;
+    auto& engine=match.engines[side];
+    engine=Engine::acquire(players[match.players[side]]);
+    engine->setOption("tcmove",QString::number(timeLimits.moveTime/1000));
+    engine->setOption("tcreserve",QString::number(timeLimits.startingReserve/1000));
+    engine->setOption("tcpercent",QString::number(timeLimits.carryover));
+    engine->setOption("tcmax",QString::number(timeLimits.maxReserve/1000));
+    engine->setOption("tctotal",QString::number(timeLimits.totalGameTime/1000));
+    engine->setOption("tcturns",QString::number(timeLimits.maxTurns));
+    engine->setOption("tcturntime",QString::number(timeLimits.absoluteMoveTime/1000));
+    connect(engine.get(),&Engine::receivedBestMove,&match,[this,&match,side](const QString& move) {
+      if (match.node->gameState.sideToMove==side)
+        receiveMove(match,move);
+    });
+    connect(engine.get(),&Engine::failed,&match,[this,&match,side] {
+      finishMatch(match,{otherSide(side),FORFEIT});
+    });
+  }
+  match.gameTimer.start();
+  requestMove(match);
+}
+
+void Tournament::requestMove(Match& match)
+{
+  const auto side=match.node->gameState.sideToMove;
+  auto& engine=*match.engines[side].get();
+  for (Side clockSide=FIRST_SIDE;clockSide<NUM_SIDES;increment(clockSide))
+    engine.setOption(QString(toLetter(clockSide,true))+"reserve",QString::number(match.reserves[clockSide]/1000));
+  engine.analyze(match.node);
+
+  match.timeout.start(timeLimits.allowed(match.reserves[side]));
+  match.moveTimer.start();
+}
+
+void Tournament::receiveMove(Match& match,const QString& moveString)
+{
+  const auto used=match.moveTimer.elapsed();
+  match.timeout.stop();
+  const auto side=match.node->gameState.sideToMove;
+  if (!timeLimits.charge(match.reserves[side],used))
+    return finishMatch(match,{otherSide(side),TIME_OUT});
+
+  const auto newNode=Engine::applyMove(match.node,moveString);
+  if (newNode==nullptr)
+    return finishMatch(match,{otherSide(side),ILLEGAL_MOVE});
+  match.node=newNode;
+  if (side==SECOND_SIDE)
+    ++match.turns;
+  if (match.node->result.endCondition!=NO_END)
+    finishMatch(match,match.node->result);
+  else if ((timeLimits.maxTurns>0 && match.turns>=timeLimits.maxTurns) ||
+           (timeLimits.totalGameTime>0 && match.gameTimer.elapsed()>=timeLimits.totalGameTime))
+    finishMatch(match,adjudicate(match.node));
+  else
+    requestMove(match);
+}
+
+void Tournament::finishMatch(Match& match,const Result& result)
+{
+  match.timeout.stop();
+  for (auto& engine:match.engines) {
+    disconnect(engine.get(),nullptr,&match,nullptr);
+    engine.reset();
+  }
+  ++scores[match.players[result.winner]][0];
+  ++scores[match.players[otherSide(result.winner)]][1];
+
+  const auto moveList=QString::fromStdString(toMoveList(match.node,"\\n",true));
+  const QStringList fields{QString::number(match.id),playerName(match.players[FIRST_SIDE]),playerName(match.players[SECOND_SIDE]),
+                           QString(toLetter(result.winner,true)),QString(toChar(result.endCondition)),QString::number(match.turns),moveList};
+  archive.write((fields.join('\t')+'\n').toUtf8());
+  archive.flush();
+  log<<QCoreApplication::translate("Tournament","Game %1: %2 beat %3 (%4)").arg(match.id).arg(playerName(match.players[result.winner])).arg(playerName(match.players[otherSide(result.winner)])).arg(toChar(result.endCondition))<<'\n';
+  log.flush();
+
+  matches.erase(find(matches.begin(),matches.end(),&match));
+  match.deleteLater();
+  if (!pairings.empty()) {
+    startMatch(pairings.front());
+    pairings.pop_front();
+  }
+  else if (matches.empty())
+    emit finished();
+}
+
+Result Tournament::adjudicate(const NodePtr& node)
+{
+  const auto sideToMove=node->gameState.sideToMove;
+  return {AlphaBeta::evaluate(node->gameState)>0 ? sideToMove : otherSide(sideToMove),SCORE};
+}
+
+QString Tournament::playerName(const size_t player) const
+{
+  return QString("%1:%2").arg(player+1).arg(QFileInfo(players[player].executable).completeBaseName());
+}
@@ -0,0 +1,62 @@
+#ifndef TOURNAMENT_HPP
+#define TOURNAMENT_HPP
+
+#include <deque>
+#include <QFile>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include "engine.hpp"
+
+class Tournament : public QObject {
+  Q_OBJECT
+public:
+  struct TimeLimits {
+    qint64 moveTime,startingReserve;
+    int carryover;
+    qint64 maxReserve,totalGameTime;
+    int maxTurns;
+    qint64 absoluteMoveTime;
+
+    qint64 allowed(const qint64 reserve) const;
+    bool charge(qint64& reserve,const qint64 used) const;
+    static TimeLimits parse(const QString& timeControl);
+    static qint64 parseDuration(const QString& duration);
+  };
+
+  Tournament(const std::vector<Engine::Configuration>& players_,const TimeLimits& timeLimits_,const unsigned int gamesPerPairing,const unsigned int numConcurrentGames_,QFile& archive_,QTextStream& log_,QObject* const parent=nullptr);
+  void start();
+  static int run(const QString& playerList,const QString& timeControl,const unsigned int gamesPerPairing,const QString& archiveName,QTextStream& log);
+private:
+  struct Match : public QObject {
+    explicit Match(QObject* const parent) : QObject(parent),timeout(this) {}
+
+    std::array<size_t,NUM_SIDES> players;
+    std::array<std::shared_ptr<Engine>,NUM_SIDES> engines;
+    std::array<qint64,NUM_SIDES> reserves;
+    NodePtr node;
+    QElapsedTimer gameTimer,moveTimer;
+    QTimer timeout;
+    int turns;
+    size_t id;
+  };
+  void startMatch(const std::array<size_t,NUM_SIDES>& players);
+  void requestMove(Match& match);
+  void receiveMove(Match& match,const QString& moveString);
+  void finishMatch(Match& match,const Result& result);
+  static Result adjudicate(const NodePtr& node);
+  QString playerName(const size_t player) const;
+
+  const std::vector<Engine::Configuration> players;
+  const TimeLimits timeLimits;
+  const unsigned int numConcurrentGames;
+  QFile& archive;
+  QTextStream& log;
+  std::deque<std::array<size_t,NUM_SIDES> > pairings;
+  std::vector<Match*> matches;
+  std::vector<std::array<unsigned int,NUM_SIDES> > scores;
+  size_t numStarted;
+signals:
+  void finished();
+};
+
+#endif // TOURNAMENT_HPP
@@ -137,7 +137,13 @@ QVariant TreeModel::data(const QModelIndex& index,const int role) const
     if (role==Qt::DisplayRole) {
       const unsigned int column=index.column();
       if (column==0) {
-        const auto moveNumber=QString::fromStdString(node->toPlyString(*root));
+        auto moveNumber=QString::fromStdString(node->toPlyString(*root));
+        if ((node->threats&Node::MISSED_WIN)!=0)
+          moveNumber+="??";
+        if ((node->threats&Node::GOAL_THREAT)!=0)
+          moveNumber+='+';
+        if ((node->threats&Node::CAPTURE_THREAT)!=0)
+          moveNumber+='x';
         const auto numChildren=rowCount(index);
         switch (numChildren) {
           case 0: return moveNumber;
@@ -172,6 +178,19 @@ QVariant TreeModel::data(const QModelIndex& index,const int role) const
     }
     else if (role==Qt::BackgroundRole)
       return node->cumulativeChildIndex()%2==0 ? QPalette().base() : QPalette().alternateBase();
+    else if (role==Qt::ToolTipRole) {
+      QStringList lines;
+      if ((node->threats&Node::MISSED_WIN)!=0)
+        lines.append(tr("Missed a win"));
+      if ((node->threats&Node::GOAL_THREAT)!=0)
+        lines.append(tr("Threatens goal"));
+      if ((node->threats&Node::CAPTURE_THREAT)!=0)
+        lines.append(tr("Threatens capture"));
+      if (!node->bestMove.empty())
+        lines.append(tr("Score: %1\nBest move: %2").arg(QString::fromStdString(node->score)).arg(QString::fromStdString(node->bestMove)));
+      if (!lines.isEmpty())
+        return lines.join('\n');
+    }
   }
   return QVariant();
 }
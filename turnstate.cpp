@@ -1,3 +1,5 @@
+#include <random>
+#include <limits>
 #include "turnstate.hpp"
 #include "gamestate.hpp"
 
@@ -236,3 +238,109 @@ std::vector<TurnState::TypeToType> TurnState::typeRemappings(const PieceCounts&
     }
   }
 }
+
+const std::vector<TurnState::TypeToType>& TurnState::cachedTypeRemappings(const PieceCounts& pieceCounts)
+{
+  // Remappings only depend on which sides have each type and on the larger of their counts.
+  static const auto table=[] {
+    unsigned int numKeys=1;
+    for (PieceType pieceType=SECOND_PIECE_TYPE;pieceType<NUM_PIECE_TYPES;increment(pieceType))
+      numKeys*=numTypeKeys(pieceType);
+    std::vector<std::vector<TypeToType> > result(numKeys);
+    for (unsigned int key=0;key<numKeys;++key) {
+      PieceCounts counts;
+      fill(counts,0);
+      unsigned int remainder=key;
+      for (PieceType pieceType=SECOND_PIECE_TYPE;pieceType<NUM_PIECE_TYPES;increment(pieceType)) {
+        const auto typeKey=remainder%numTypeKeys(pieceType);
+        remainder/=numTypeKeys(pieceType);
+        if (typeKey>0) {
+          const auto presence=(typeKey-1)/numStartingPiecesPerType[pieceType];
+          const auto maxCount=(typeKey-1)%numStartingPiecesPerType[pieceType]+1;
+          counts[toPieceTypeAndSide(pieceType,FIRST_SIDE)]=(presence==0 ? 0 : maxCount);
+          counts[toPieceTypeAndSide(pieceType,SECOND_SIDE)]=(presence==1 ? 0 : presence==0 ? maxCount : 1);
+        }
+      }
+      result[key]=typeRemappings(counts);
+    }
+    return result;
+  }();
+
+  unsigned int key=0;
+  unsigned int multiplier=1;
+  for (PieceType pieceType=SECOND_PIECE_TYPE;pieceType<NUM_PIECE_TYPES;increment(pieceType)) {
+    const auto firstCount=pieceCounts[toPieceTypeAndSide(pieceType,FIRST_SIDE)];
+    const auto secondCount=pieceCounts[toPieceTypeAndSide(pieceType,SECOND_SIDE)];
+    const auto maxCount=std::max(firstCount,secondCount);
+    if (maxCount>0) {
+      runtime_assert(maxCount<=numStartingPiecesPerType[pieceType],"More pieces of a type than at the start.");
+      const unsigned int presence=(firstCount==0 ? 0 : secondCount==0 ? 1 : 2);
+      key+=multiplier*(1+presence*numStartingPiecesPerType[pieceType]+maxCount-1);
+    }
+    multiplier*=numTypeKeys(pieceType);
+  }
+  return table[key];
+}
+
+unsigned int TurnState::numTypeKeys(const PieceType pieceType)
+{
+  return 1+3*numStartingPiecesPerType[pieceType];
+}
+
+TurnState::Hash TurnState::hash() const
+{
+  const auto& keys=zobristKeys();
+  Hash result=(sideToMove==FIRST_SIDE ? 0 : keys.secondSide);
+  for (SquareIndex square=FIRST_SQUARE;square<NUM_SQUARES;increment(square)) {
+    const auto piece=squarePieces[square];
+    if (piece!=NO_PIECE)
+      result^=keys.squarePieces[piece][square];
+  }
+  return result;
+}
+
+TurnState::Hash TurnState::canonicalHash() const
+{
+  const auto& keys=zobristKeys();
+  const auto pieceCounts_=pieceCounts();
+  Hash result=std::numeric_limits<Hash>::max();
+  for (const bool flipped:{false,true}) {
+    PieceCounts counts;
+    for (unsigned int piece=0;piece<NUM_PIECE_SIDE_COMBINATIONS;++piece)
+      counts[piece]=pieceCounts_[flipped ? toOtherSide(PieceTypeAndSide(piece)) : piece];
+    const Hash sideKey=((sideToMove==FIRST_SIDE)!=flipped ? 0 : keys.secondSide);
+    for (const auto& remapping:cachedTypeRemappings(counts))
+      for (const bool mirrored:{false,true}) {
+        Hash hash=sideKey;
+        for (SquareIndex square=FIRST_SQUARE;square<NUM_SQUARES;increment(square)) {
+          auto piece=squarePieces[square];
+          if (piece==NO_PIECE)
+            continue;
+          auto target=square;
+          if (flipped) {
+            target=invert(target);
+            piece=toOtherSide(piece);
+          }
+          if (mirrored)
+            target=::mirror(target);
+          hash^=keys.squarePieces[toPieceTypeAndSide(remapping[toPieceType(piece)],toSide(piece))][target];
+        }
+        result=std::min(result,hash);
+      }
+  }
+  return result;
+}
+
+const TurnState::ZobristKeys& TurnState::zobristKeys()
+{
+  static const ZobristKeys keys=[] {
+    std::mt19937_64 rndEngine(0);
+    ZobristKeys result;
+    for (auto& pieceKeys:result.squarePieces)
+      for (auto& key:pieceKeys)
+        key=rndEngine();
+    result.secondSide=rndEngine();
+    return result;
+  }();
+  return keys;
+}
@@ -2,6 +2,7 @@
 #define TURNSTATE_HPP
 
 #include <array>
+#include <cstdint>
 #include "def.hpp"
 
 class TurnState {
@@ -9,6 +10,7 @@ public:
   typedef std::array<PieceTypeAndSide,NUM_SQUARES> Board;
   typedef std::array<unsigned int,NUM_PIECE_SIDE_COMBINATIONS> PieceCounts;
   typedef std::array<PieceType,NUM_PIECE_TYPES> TypeToType;
+  typedef std::uint64_t Hash;
 
   explicit TurnState(const Side sideToMove_=FIRST_SIDE,Board squarePieces_=emptyBoard());
   virtual ~TurnState() {}
@@ -37,6 +39,18 @@ public:
   static TypeToType typeToRanks(const PieceCounts& pieceCounts);
   static std::vector<TypeToType> typeRemappings(const PieceCounts& pieceCounts,const TypeToType& typeToRanks,const PieceType source,TypeToType& currentRemapping);
   static std::vector<TypeToType> typeRemappings(const PieceCounts& pieceCounts);
+  static const std::vector<TypeToType>& cachedTypeRemappings(const PieceCounts& pieceCounts);
+
+  Hash hash() const;
+  Hash canonicalHash() const;
+private:
+  struct ZobristKeys {
+    std::array<std::array<Hash,NUM_SQUARES>,NUM_PIECE_SIDE_COMBINATIONS> squarePieces;
+    Hash secondSide;
+  };
+  static unsigned int numTypeKeys(const PieceType pieceType);
+  static const ZobristKeys& zobristKeys();
+public:
 
   Side sideToMove;
   Board squarePieces;
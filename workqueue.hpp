@@ -0,0 +1,89 @@
+#ifndef WORKQUEUE_HPP
+#define WORKQUEUE_HPP
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+
+template<class Task>
+class WorkStealingQueue {
+public:
+  explicit WorkStealingQueue(const unsigned int numWorkers) :
+    queues(numWorkers),
+    pending(0),
+    queued(0) {}
+
+  void push(const unsigned int worker,Task task)
+  {
+    ++pending;
+    auto& queue=queues[worker%queues.size()];
+    {
+      const std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.emplace_back(std::move(task));
+    }
+    ++queued;
+    notify(false);
+  }
+
+  void run(const unsigned int worker)
+  {
+    Task task;
+    while (true)
+      if (pop(worker,task)) {
+        task(worker);
+        if (--pending==0)
+          notify(true);
+      }
+      else {
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        idle.wait(lock,[this]{return pending==0 || queued>0;});
+        if (pending==0)
+          return;
+      }
+  }
+private:
+  void notify(const bool all)
+  {
+    // Taking the lock orders the notification after any waiter's check of its condition.
+    { const std::lock_guard<std::mutex> lock(idle_mutex); }
+    if (all)
+      idle.notify_all();
+    else
+      idle.notify_one();
+  }
+
+  bool pop(const unsigned int worker,Task& task)
+  {
+    for (size_t offset=0;offset<queues.size();++offset) {
+      auto& queue=queues[(worker+offset)%queues.size()];
+      const std::lock_guard<std::mutex> lock(queue.mutex);
+      if (!queue.tasks.empty()) {
+        --queued;
+        if (offset==0) {
+          task=std::move(queue.tasks.back());
+          queue.tasks.pop_back();
+        }
+        else {
+          task=std::move(queue.tasks.front());
+          queue.tasks.pop_front();
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+  std::vector<Queue> queues;
+  std::atomic<size_t> pending,queued;
+  std::mutex idle_mutex;
+  std::condition_variable idle;
+};
+
+#endif // WORKQUEUE_HPP